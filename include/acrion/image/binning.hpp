@@ -0,0 +1,237 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "orientation.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    enum class BinMode
+    {
+        Sum,     // saturates to the range of the output type
+        Average, // rounded to the nearest value for integer output types
+    };
+
+    namespace detail
+    {
+        /// Sums of up to 2^32 samples of 32 bit are exact in 64 bit; wider samples are summed in double precision.
+        template <typename T>
+        using BinAccumulator = std::conditional_t<std::is_integral_v<T> && sizeof(T) <= 4, uint64_t, double>;
+
+        /// Adds the sums of `factor` horizontally adjacent pixels of `in` to the n pixels of `sum`. A factor known at
+        /// compile time (F > 0) unrolls, so the compiler turns the loop into pairwise vector additions.
+        template <int C, int F, typename T, typename Accumulator>
+        void AddBinnedRow(const T* in, Accumulator* sum, const int n, const int factor)
+        {
+            if constexpr (F > 0)
+            {
+#pragma omp simd
+                for (int i = 0; i < n; ++i)
+                {
+                    for (int c = 0; c < C; ++c)
+                    {
+                        Accumulator s = 0;
+                        for (int f = 0; f < F; ++f)
+                        {
+                            s += in[(i * F + f) * C + c];
+                        }
+                        sum[i * C + c] += s;
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 0; i < n; ++i)
+                {
+                    const T* p = in + (size_t)i * factor * C;
+                    for (int f = 0; f < factor; ++f, p += C)
+                    {
+                        for (int c = 0; c < C; ++c)
+                        {
+                            sum[i * C + c] += p[c];
+                        }
+                    }
+                }
+            }
+        }
+
+        /// the binned sum or average `value` of `count` samples as sample of U
+        template <typename U, typename Accumulator>
+        inline U BinnedSample(const Accumulator value, const Accumulator count, const BinMode mode)
+        {
+            if constexpr (std::is_integral_v<Accumulator>)
+            {
+                if constexpr (std::is_floating_point_v<U>)
+                {
+                    return mode == BinMode::Sum ? (U)value : (U)value / (U)count;
+                }
+                else
+                {
+                    const Accumulator v = mode == BinMode::Sum ? value : (value + count / 2) / count;
+                    return (U)std::min<Accumulator>(v, std::numeric_limits<U>::max());
+                }
+            }
+            else
+            {
+                return ToSample<U>(mode == BinMode::Sum ? value : value / count);
+            }
+        }
+
+        /// The binned value of a block whose `count` samples all equal `value`, for the display range. In double
+        /// precision the sum is taken only for Sum and saturates to the finite range of U, so that the default
+        /// range of floating point images, which ends at the largest double, does not become infinite.
+        template <typename U, typename T>
+        inline U BinnedBound(const T value, const BinAccumulator<T> count, const BinMode mode)
+        {
+            if constexpr (std::is_floating_point_v<BinAccumulator<T>>)
+            {
+                const double v = mode == BinMode::Sum ? (double)value * count : (double)value;
+                if constexpr (std::is_floating_point_v<U>)
+                {
+                    return (U)std::max<double>(std::numeric_limits<U>::lowest(), std::min<double>(std::numeric_limits<U>::max(), v));
+                }
+                else
+                {
+                    return ToSample<U>(v);
+                }
+            }
+            else
+            {
+                return BinnedSample<U>((BinAccumulator<T>)value * count, count, mode);
+            }
+        }
+
+        template <int C, int F, typename U, typename T>
+        void Bin(const BitmapData<T>& source, BitmapData<U>& destination, const int factorX, const int factorY, const BinMode mode)
+        {
+            using Accumulator = BinAccumulator<T>;
+
+            const int         width  = destination.Width();
+            const int         height = destination.Height();
+            const size_t      stride = (size_t)source.Width() * C;
+            const Accumulator count  = (Accumulator)factorX * factorY;
+
+#pragma omp parallel
+            {
+                std::vector<Accumulator> sum((size_t)width * C);
+
+#pragma omp for
+                for (int y = 0; y < height; ++y)
+                {
+                    std::fill(sum.begin(), sum.end(), Accumulator(0));
+
+                    for (int r = 0; r < factorY; ++r)
+                    {
+                        AddBinnedRow<C, F>(source.Buffer() + ((size_t)y * factorY + r) * stride, sum.data(), width, factorX);
+                    }
+
+                    U* out = destination.Buffer() + (size_t)y * width * C;
+                    for (size_t e = 0; e < sum.size(); ++e)
+                    {
+                        out[e] = BinnedSample<U>(sum[e], count, mode);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Combines each block of `factorX` x `factorY` pixels of `source` into one pixel of `destination`, which must
+    /// have the binned size (source size divided by the factors, rounded down; incomplete blocks at the right and
+    /// bottom border are dropped) and the same channels. The output type U may be wider than T to hold sums
+    /// without saturation, e.g. BitmapData<uint32_t> for 2 x 2 sums of uint16_t. Runs in parallel over output rows.
+    template <typename U, typename T>
+    void Bin(const BitmapData<T>& source, BitmapData<U>& destination, const int factorX, const int factorY, const BinMode mode = BinMode::Average)
+    {
+        if (factorX < 1 || factorY < 1)
+        {
+            throw std::runtime_error("acrion::image::Bin: invalid factors " + std::to_string(factorX) + " x " + std::to_string(factorY));
+        }
+
+        if (destination.Width() != source.Width() / factorX || destination.Height() != source.Height() / factorY || destination.Channels() != source.Channels())
+        {
+            throw std::runtime_error("acrion::image::Bin: destination must have " + std::to_string(source.Width() / factorX) + " x " + std::to_string(source.Height() / factorY) + " pixels of " + std::to_string(source.Channels()) + " channels");
+        }
+
+        detail::WithChannels(source.Channels(), [&](auto channels)
+        {
+            constexpr int C = decltype(channels)::value;
+
+            switch (factorX)
+            {
+            case 2:
+                detail::Bin<C, 2>(source, destination, factorX, factorY, mode);
+                break;
+            case 3:
+                detail::Bin<C, 3>(source, destination, factorX, factorY, mode);
+                break;
+            case 4:
+                detail::Bin<C, 4>(source, destination, factorX, factorY, mode);
+                break;
+            default:
+                detail::Bin<C, 0>(source, destination, factorX, factorY, mode);
+                break;
+            }
+        });
+
+        const auto count = (detail::BinAccumulator<T>)factorX * factorY;
+        destination.SetBrightnessRangeForDisplay(detail::BinnedBound<U>(source.GetMinDisplayedBrightness(), count, mode),
+                                                 detail::BinnedBound<U>(source.GetMaxDisplayedBrightness(), count, mode));
+        destination.Invalidate();
+    }
+
+    /// Same with the output type U selectable, T by default: Bin<uint32_t>(image16, 2, 2, BinMode::Sum).
+    template <typename U = void, typename T>
+    auto Bin(const BitmapData<T>& source, const int factorX, const int factorY, const BinMode mode = BinMode::Average)
+    {
+        using Output = std::conditional_t<std::is_void_v<U>, T, U>;
+
+        if (factorX < 1 || factorY < 1)
+        {
+            throw std::runtime_error("acrion::image::Bin: invalid factors " + std::to_string(factorX) + " x " + std::to_string(factorY));
+        }
+
+        BitmapData<Output> destination(source.Width() / factorX, source.Height() / factorY, source.Channels());
+        Bin(source, destination, factorX, factorY, mode);
+        return destination;
+    }
+
+    /// N x N binning
+    template <typename U = void, typename T>
+    auto Bin(const BitmapData<T>& source, const int factor, const BinMode mode = BinMode::Average)
+    {
+        return Bin<U>(source, factor, factor, mode);
+    }
+}
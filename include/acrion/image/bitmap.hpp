@@ -26,6 +26,7 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include "bitmap_data.hpp"
+#include "depth_conversion.hpp"
 
 #include <cbeam/container/xpod.hpp>
 
@@ -424,6 +425,98 @@ namespace acrion::image
             }
         }
 
+        uint8_t* ConvertToDepth8(const DisplayOptions& options, int x = 0, int y = 0, int width = 0, int height = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            switch (_index)
+            {
+            case 0:
+                return std::get<0>(_bitmapData).ConvertToDepth8(options, x, y, width, height, scaledWidth, scaledHeight);
+            case 1:
+                return std::get<1>(_bitmapData).ConvertToDepth8(options, x, y, width, height, scaledWidth, scaledHeight);
+            case 2:
+                return std::get<2>(_bitmapData).ConvertToDepth8(options, x, y, width, height, scaledWidth, scaledHeight);
+            case 3:
+                return std::get<3>(_bitmapData).ConvertToDepth8(options, x, y, width, height, scaledWidth, scaledHeight);
+            case 4:
+                return std::get<4>(_bitmapData).ConvertToDepth8(options, x, y, width, height, scaledWidth, scaledHeight);
+            default:
+                throw std::runtime_error("acrion::image::Bitmap::ConvertToDepth8: Unsupported image depth " + std::to_string(Depth()));
+            }
+        }
+
+        DisplayBuffer ConvertToDepth8(DisplayBufferPool& pool, const DisplayOptions& options = {}, int x = 0, int y = 0, int width = 0, int height = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            switch (_index)
+            {
+            case 0:
+                return std::get<0>(_bitmapData).ConvertToDepth8(pool, options, x, y, width, height, scaledWidth, scaledHeight);
+            case 1:
+                return std::get<1>(_bitmapData).ConvertToDepth8(pool, options, x, y, width, height, scaledWidth, scaledHeight);
+            case 2:
+                return std::get<2>(_bitmapData).ConvertToDepth8(pool, options, x, y, width, height, scaledWidth, scaledHeight);
+            case 3:
+                return std::get<3>(_bitmapData).ConvertToDepth8(pool, options, x, y, width, height, scaledWidth, scaledHeight);
+            case 4:
+                return std::get<4>(_bitmapData).ConvertToDepth8(pool, options, x, y, width, height, scaledWidth, scaledHeight);
+            default:
+                throw std::runtime_error("acrion::image::Bitmap::ConvertToDepth8: Unsupported image depth " + std::to_string(Depth()));
+            }
+        }
+
+        void ConvertToDepth8(uint8_t* destination, size_t destStride, const DisplayOptions& options, int x = 0, int y = 0, int width = 0, int height = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            switch (_index)
+            {
+            case 0:
+                std::get<0>(_bitmapData).ConvertToDepth8(destination, destStride, options, x, y, width, height, scaledWidth, scaledHeight);
+                break;
+            case 1:
+                std::get<1>(_bitmapData).ConvertToDepth8(destination, destStride, options, x, y, width, height, scaledWidth, scaledHeight);
+                break;
+            case 2:
+                std::get<2>(_bitmapData).ConvertToDepth8(destination, destStride, options, x, y, width, height, scaledWidth, scaledHeight);
+                break;
+            case 3:
+                std::get<3>(_bitmapData).ConvertToDepth8(destination, destStride, options, x, y, width, height, scaledWidth, scaledHeight);
+                break;
+            case 4:
+                std::get<4>(_bitmapData).ConvertToDepth8(destination, destStride, options, x, y, width, height, scaledWidth, scaledHeight);
+                break;
+            default:
+                throw std::runtime_error("acrion::image::Bitmap::ConvertToDepth8: Unsupported image depth " + std::to_string(Depth()));
+            }
+        }
+
+        /// Returns a copy of this image converted to the given depth (see Depth()), using the same
+        /// geometry. With the default conversion, values are saturated to the destination range.
+        Bitmap ConvertDepth(int depth, const DepthConversion& conversion = {}) const
+        {
+            Bitmap result(Width(), Height(), Channels(), depth);
+
+            switch (result._index)
+            {
+            case 0:
+                ConvertDepthInto(std::get<0>(result._bitmapData), conversion);
+                break;
+            case 1:
+                ConvertDepthInto(std::get<1>(result._bitmapData), conversion);
+                break;
+            case 2:
+                ConvertDepthInto(std::get<2>(result._bitmapData), conversion);
+                break;
+            case 3:
+                ConvertDepthInto(std::get<3>(result._bitmapData), conversion);
+                break;
+            case 4:
+                ConvertDepthInto(std::get<4>(result._bitmapData), conversion);
+                break;
+            default:
+                throw std::runtime_error("acrion::image::Bitmap::ConvertDepth: Unsupported image depth " + std::to_string(depth));
+            }
+
+            return result;
+        }
+
         std::shared_ptr<Bitmap> AbsoluteDiff(const Bitmap& other)
         {
             switch (_index)
@@ -491,6 +584,31 @@ namespace acrion::image
         }
 
     private:
+        template <typename U>
+        void ConvertDepthInto(BitmapData<U>& destination, const DepthConversion& conversion) const
+        {
+            switch (_index)
+            {
+            case 0:
+                image::ConvertDepth(std::get<0>(_bitmapData), destination, conversion);
+                break;
+            case 1:
+                image::ConvertDepth(std::get<1>(_bitmapData), destination, conversion);
+                break;
+            case 2:
+                image::ConvertDepth(std::get<2>(_bitmapData), destination, conversion);
+                break;
+            case 3:
+                image::ConvertDepth(std::get<3>(_bitmapData), destination, conversion);
+                break;
+            case 4:
+                image::ConvertDepth(std::get<4>(_bitmapData), destination, conversion);
+                break;
+            default:
+                throw std::runtime_error("acrion::image::Bitmap::ConvertDepth: Unsupported image depth " + std::to_string(Depth()));
+            }
+        }
+
         static void* GetBuffer(const BitmapContainer& image)
         {
             return image.get_mapped_value_or_throw<cbeam::memory::pointer>(std::string(bufferKey), "acrion::image::Bitmap::GetBuffer()");
@@ -25,7 +25,10 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "change_tracker.hpp"
 #include "color.hpp"
+#include "display_buffer_pool.hpp"
+#include "display_transform.hpp"
 #include "interpolation.hpp"
 #include "utility.hpp"
 #include "vector.hpp"
@@ -35,27 +38,27 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 
 // #include <opencv2/opencv.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace acrion::image
 {
     using namespace std::placeholders;
 
-    inline double     _currentGamma = -1;
-    inline uint8_t    _gammaTable[65536];
-    inline std::mutex _mtx;
-
     using Drawer  = std::function<bool(const int x, const int y)>;
     using DrawerF = std::function<bool(const double x, const double y)>;
 
@@ -65,32 +68,6 @@ namespace acrion::image
         {
             return std::pow(2.0, (double)sizeOfType * 8.0);
         }
-
-        void FillGammaTable(double gamma)
-        {
-            std::lock_guard<std::mutex> lock(_mtx);
-
-            if (gamma != _currentGamma)
-            {
-                _currentGamma = gamma;
-
-                double gamma1 = gamma * 2;
-                if (gamma1 > 1) gamma1 = 1;
-
-                double       delta  = 9 - gamma * 6;
-                const double log2   = log(2.0);
-                double       factor = 256.0 / (log(65536.0) / log2 - delta);
-
-                for (int v = 0; v < 65536; ++v)
-                {
-                    double val0    = v / 256.0;
-                    double result  = log((double)v) / log2 - delta; // cppcheck-suppress invalidFunctionArg
-                    double val1    = (result <= 0) ? 0 : result * factor;
-                    double t       = gamma1 * val1 + (1 - gamma1) * val0;
-                    _gammaTable[v] = (unsigned char)t;
-                }
-            }
-        }
     }
 
     template <typename T>
@@ -179,6 +156,7 @@ namespace acrion::image
             destination._blueIndex              = _blueIndex;
             destination._minDisplayedBrightness = _minDisplayedBrightness;
             destination._maxDisplayedBrightness = _maxDisplayedBrightness;
+            destination.Invalidate();
         }
 
         BitmapData& operator=(const BitmapData& src)
@@ -195,6 +173,11 @@ namespace acrion::image
                 _channels = src.Channels();
                 _buffer   = cbeam::container::stable_reference_buffer(Size(), sizeof(uint8_t));
                 Init();
+
+                if (_changes)
+                {
+                    _changes = std::make_shared<ChangeTracker>(_width, _height);
+                }
             }
 
             src.Copy(*this);
@@ -215,6 +198,7 @@ namespace acrion::image
             _blueIndex              = other._blueIndex;
             _minDisplayedBrightness = other._minDisplayedBrightness;
             _maxDisplayedBrightness = other._maxDisplayedBrightness;
+            _changes                = other._changes;
             return *this;
         }
 
@@ -223,9 +207,38 @@ namespace acrion::image
 #pragma omp parallel for
             for (int y = 0; y < Height(); ++y)
                 for (int x = 0; x < Width(); ++x)
-                    Plot(x, y, color);
+                    WritePixel(x, y, color);
+
+            Invalidate();
         }
 
+        /// Starts recording which parts of the image change (see ChangeTracker) and returns the tracker. Display
+        /// caches call this; until then, change tracking costs a single null check per modification. Not thread-safe
+        /// with respect to other calls of this function.
+        std::shared_ptr<const ChangeTracker> TrackChanges() const
+        {
+            if (!_changes)
+            {
+                _changes = std::make_shared<ChangeTracker>(_width, _height);
+            }
+            return _changes;
+        }
+
+        /// the change tracker created by TrackChanges(), or nullptr
+        const ChangeTracker* Changes() const { return _changes.get(); }
+
+        /// Tells change tracking that the pixels in the region (x, y, w, h) were modified. Member functions and the
+        /// conversion functions of this library do this themselves; call it after writing through Buffer().
+        void Invalidate(const int x, const int y, const int w, const int h) const
+        {
+            if (_changes)
+            {
+                _changes->MarkDirty(x, y, w, h);
+            }
+        }
+
+        void Invalidate() const { Invalidate(0, 0, _width, _height); }
+
         T*  Buffer() const { return (T*)_buffer.get(); }
         int Stride() const { return _width * BytesPerPixel(); } // the scan width (in bytes). BitmapData never uses alignment, so it simply equals width * bytesPerPixel
         int BytesPerPixel() const { return _channels * std::abs(Depth()); }
@@ -337,24 +350,47 @@ namespace acrion::image
             }
         }
 
-        Color<T> Get(const double dx, const double dy) const
+        /// Interpolates at the sub-pixel position (dx, dy), see interpolation::Do and interpolation::DoTabulated.
+        Color<T> Get(const double dx, const double dy, const interpolation::Mode mode = interpolation::Mode::Exact) const
         {
-            interpolation::Getter<Color<T>> getter = [this](const int x, const int y)
+            const auto getter = [this](const int x, const int y)
             {
                 return Get(x, y);
             };
 
-            return interpolation::Do(dx, dy, 0.0, 0.0, Width() - 1.0, Height() - 1.0, getter);
+            return mode == interpolation::Mode::Tabulated ? interpolation::DoTabulated(dx, dy, 0.0, 0.0, Width() - 1.0, Height() - 1.0, getter)
+                                                          : interpolation::Do(dx, dy, 0.0, 0.0, Width() - 1.0, Height() - 1.0, getter);
         }
 
-        T GetGray(const double dx, const double dy) const
+        T GetGray(const double dx, const double dy, const interpolation::Mode mode = interpolation::Mode::Exact) const
         {
-            interpolation::Getter<MixableScalar<T>> getter = [this](const int x, const int y)
+            const auto getter = [this](const int x, const int y)
             {
                 return MixableScalar<T>(GetGray(x, y));
             };
 
-            return interpolation::Do(dx, dy, 0.0, 0.0, Width() - 1.0, Height() - 1.0, getter);
+            return mode == interpolation::Mode::Tabulated ? interpolation::DoTabulated(dx, dy, 0.0, 0.0, Width() - 1.0, Height() - 1.0, getter)
+                                                          : interpolation::Do(dx, dy, 0.0, 0.0, Width() - 1.0, Height() - 1.0, getter);
+        }
+
+        /// Interpolates at `count` sub-pixel positions (x, y) and writes the results to `colors[0 .. count)`, in
+        /// the order of `positions`. Equivalent to calling Get(x, y, mode) per position, but the queries are
+        /// processed bucketed by source row for cache locality, and in parallel.
+        void Get(const std::pair<double, double>* positions, const size_t count, Color<T>* colors, const interpolation::Mode mode = interpolation::Mode::Exact) const
+        {
+            SampleBatch("Get", positions, count, colors, [this, mode](const double dx, const double dy)
+            {
+                return Get(dx, dy, mode);
+            });
+        }
+
+        /// same as Get(positions, count, colors, mode) for the gray value, see GetGray(double, double, mode)
+        void GetGray(const std::pair<double, double>* positions, const size_t count, T* values, const interpolation::Mode mode = interpolation::Mode::Exact) const
+        {
+            SampleBatch("GetGray", positions, count, values, [this, mode](const double dx, const double dy)
+            {
+                return GetGray(dx, dy, mode);
+            });
         }
 
         Color<T> Max(int x0, int y0, int x1, int y1, int* brightestX = nullptr, int* brightestY = nullptr) const
@@ -675,45 +711,39 @@ namespace acrion::image
             return result;
         }
 
+        /// Sets one pixel and marks it as changed. Once a display cache tracks the image, each mark costs a memory
+        /// fence; to plot many pixels, pass `invalidate` = false and call Invalidate for their region once.
         bool Plot(const int x, const int y, const Color<T>& color) const
+        {
+            return Plot(x, y, color, true);
+        }
+
+        bool Plot(const int x, const int y, const Color<T>& color, const bool invalidate) const
         {
             if (x < 0 || y < 0 || x >= Width() || y >= Height())
             {
                 return true;
             }
 
-            T* ptr = Buffer() + (y * _width + x) * _channels;
-
-            if (_grayIndex != -1)
+            WritePixel(x, y, color);
+            if (invalidate)
             {
-                ptr[_grayIndex] = color.Gray();
-            }
-            else
-            {
-                ptr[_redIndex]   = color.Red();
-                ptr[_greenIndex] = color.Green();
-                ptr[_blueIndex]  = color.Blue();
-            }
-
-            if (_alphaIndex == -1)
-            {
-                if (color.Alpha() != std::numeric_limits<T>().max())
-                {
-                    throw std::runtime_error("BitmapData::Set: Cannot set alpha channel to " + std::to_string(color.Alpha()) + " in an image with " + std::to_string(_channels) + " channels.");
-                }
-            }
-            else
-            {
-                ptr[_alphaIndex] = color.Alpha();
+                Invalidate(x, y, 1, 1);
             }
 
             return true;
         }
 
+        /// Draws a line and marks its bounding box as changed once, instead of once per pixel as Plot does.
         void Draw(const int x0, const int y0, const int x1, const int y1, const Color<T>& color) const
         {
-            auto plot = std::bind(&BitmapData<T>::Plot, this, _1, _2, color);
-            Draw(x0, y0, x1, y1, plot);
+            const auto write = [this, &color](const int x, const int y)
+            {
+                WritePixel(x, y, color);
+                return true;
+            };
+            Draw(x0, y0, x1, y1, write);
+            Invalidate(std::min(x0, x1), std::min(y0, y1), std::abs(x1 - x0) + 1, std::abs(y1 - y0) + 1);
         }
 
         void Draw(int x0, int y0, const int x1, const int y1, const Drawer& draw) const
@@ -788,10 +818,12 @@ namespace acrion::image
             {
                 for (int i = 0; i < _width; ++i)
                 {
-                    Plot(i, j, Get(i, j) + rhs.Get(i, j));
+                    WritePixel(i, j, Get(i, j) + rhs.Get(i, j));
                 }
             }
 
+            Invalidate();
+
             return *this; // return the result by reference
         }
 
@@ -802,10 +834,12 @@ namespace acrion::image
             {
                 for (int i = 0; i < _width; ++i)
                 {
-                    Plot(i, j, Get(i, j) - rhs.Get(i, j));
+                    WritePixel(i, j, Get(i, j) - rhs.Get(i, j));
                 }
             }
 
+            Invalidate();
+
             return *this; // return the result by reference
         }
 
@@ -837,138 +871,127 @@ namespace acrion::image
 
         uint8_t* ConvertToDepth8(double gamma = 0, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0) const
         {
-            if (w <= 0) w = Width() - x;
-            if (h <= 0) h = Height() - y;
-            if (scaledWidth <= 0) scaledWidth = w;
-            if (scaledHeight <= 0) scaledHeight = h;
+            DisplayOptions options;
+            options.gamma = gamma;
+            return ConvertToDepth8(options, x, y, w, h, scaledWidth, scaledHeight);
+        }
 
-            FillGammaTable(gamma);
+        /// Converts using the shared DisplayTransform for `options` and the displayed brightness range of this image.
+        uint8_t* ConvertToDepth8(const DisplayOptions& options, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            return ConvertToDepth8(*DisplayTransform<T>::Cached(options, _minDisplayedBrightness, _maxDisplayedBrightness), x, y, w, h, scaledWidth, scaledHeight);
+        }
 
-            size_t align, destChannels;
-            switch (_channels)
+        /// Converts the region (x, y, w, h) to 8 bit for display, ignoring the displayed brightness range of this
+        /// image in favour of the one in `transform`. If the scaled size differs, the region is scaled preserving
+        /// its aspect ratio, filling the remainder with gray. The caller owns the returned buffer (delete[]).
+        uint8_t* ConvertToDepth8(const DisplayTransform<T>& transform, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            ResolveDisplayRegion(x, y, w, h, scaledWidth, scaledHeight);
+
+            const size_t   destStride   = transform.Stride(_channels, scaledWidth);
+            unsigned char* bufferDepth8 = new unsigned char[destStride * scaledHeight];
+
+            assert(!(reinterpret_cast<uint64_t>(bufferDepth8) & 0x3)); // make sure address is 32-bit aligned (only for debugger)
+
+            ConvertToDepth8(bufferDepth8, destStride, transform, x, y, w, h, scaledWidth, scaledHeight);
+            return bufferDepth8;
+        }
+
+        /// Like above, but renders into a buffer taken from `pool` instead of allocating one. The buffer returns to
+        /// the pool when the handle is destroyed.
+        DisplayBuffer ConvertToDepth8(DisplayBufferPool& pool, const DisplayOptions& options = {}, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            ResolveDisplayRegion(x, y, w, h, scaledWidth, scaledHeight);
+
+            const auto    transform = DisplayTransform<T>::Cached(options, _minDisplayedBrightness, _maxDisplayedBrightness);
+            DisplayBuffer buffer    = pool.Acquire(scaledWidth, scaledHeight, transform->DestinationChannels(_channels), transform->Stride(_channels, scaledWidth));
+
+            ConvertToDepth8(buffer.Data(), buffer.Stride(), *transform, x, y, w, h, scaledWidth, scaledHeight);
+            return buffer;
+        }
+
+        /// Like above, but writes into the caller's `destination`, which holds scaledHeight rows of `destStride`
+        /// bytes. The stride must be at least scaledWidth * transform.DestinationChannels(Channels()); bytes beyond
+        /// that are left untouched.
+        void ConvertToDepth8(uint8_t* destination, const size_t destStride, const DisplayOptions& options, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            ConvertToDepth8(destination, destStride, *DisplayTransform<T>::Cached(options, _minDisplayedBrightness, _maxDisplayedBrightness), x, y, w, h, scaledWidth, scaledHeight);
+        }
+
+        void ConvertToDepth8(uint8_t* destination, const size_t destStride, const DisplayTransform<T>& transform, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0) const
+        {
+            ResolveDisplayRegion(x, y, w, h, scaledWidth, scaledHeight);
+
+            if (_channels < 1 || _channels > 4)
             {
-            case 1:
-            case 2:
-                destChannels = 1;
-                align        = 4;
-                break;
-            case 3:
-            case 4:
-                destChannels = 4;
-                align        = 1;
-                break;
-            default:
                 throw std::runtime_error("acrion::image::BitmapData::ConvertToDepth8: Unsupported number of channels: " + std::to_string(_channels));
             }
 
+            const DisplayLayout layout       = transform.Layout(_channels);
+            const size_t        destChannels = detail::LayoutChannels(layout);
+
+            if (destStride < (size_t)scaledWidth * destChannels)
+            {
+                throw std::runtime_error("acrion::image::BitmapData::ConvertToDepth8: stride " + std::to_string(destStride) + " is too small for " + std::to_string(scaledWidth) + " pixels of " + std::to_string(destChannels) + " bytes");
+            }
+
             std::stringstream log;
             log << "Converting image to depth 8: " << x << "/" << y << " (scaled from " << w << " x " << h << " to " << scaledWidth << "), destChannels=" << destChannels;
             CBEAM_LOG_DEBUG(log.str());
 
-            size_t         alignedWidth = (scaledWidth + align - 1) / align * align;
-            unsigned char* bufferDepth8 = new unsigned char[alignedWidth * scaledHeight * destChannels];
-
-            assert(!(reinterpret_cast<uint64_t>(bufferDepth8) & 0x3)); // make sure address is 32-bit aligned (only for debugger)
+            const ResampleFilter scaling  = transform.Options().scaling;
+            const Colormap*      colormap = _channels == 1 ? transform.Options().colormap.get() : nullptr;
 
-            if (scaledWidth == w && scaledHeight == h)
+            // for false colour the display value of each pixel is looked up in the colormap in the same pass
+            const auto convert = [&](const auto& map)
             {
-#pragma omp parallel for
-                for (int j = 0; j < h; j++)
+                if (colormap)
                 {
-                    unsigned char* dest = bufferDepth8 + j * alignedWidth * destChannels;
-                    T*             src  = Buffer() + (x + (j + y) * Width()) * _channels;
-
-                    for (int i = 0; i < w; i++, src += _channels, dest += destChannels)
-                    {
-                        if (y + j >= 0 && y + j < Height() && x + i >= 0 && x + i < Width())
-                        {
-                            if (_channels == 3)
-                            {
-                                dest[0] = CalculateDisplayValue(src[2]); // B
-                                dest[1] = CalculateDisplayValue(src[1]); // G
-                                dest[2] = CalculateDisplayValue(src[0]); // R
-                                dest[3] = 255;                           // A
-                            }
-                            else if (_channels == 4)
-                            {
-                                dest[0] = CalculateDisplayValue(src[3]); // B
-                                dest[1] = CalculateDisplayValue(src[2]); // G
-                                dest[2] = CalculateDisplayValue(src[1]); // R
-                                dest[3] = CalculateDisplayValue(src[0]); // A
-                            }
-                            else
-                            {
-                                dest[0] = CalculateDisplayValue(src[0]);
-                            }
-                        }
-                        else
-                        {
-                            for (size_t k = 0; k < destChannels; ++k)
-                            {
-                                dest[k] = 55;
-                            }
-                        }
-                    }
+                    const detail::PaletteMap<std::decay_t<decltype(map)>> palette{map, colormap};
+                    ConvertToDepth8(destination, destStride, layout, palette, scaling, x, y, w, h, scaledWidth, scaledHeight);
                 }
-            }
-            else
-            {
-                const double aspectRatio        = static_cast<double>(w) / h;
-                const bool   destinationIsWider = static_cast<double>(scaledWidth) / scaledHeight > aspectRatio;
-                const int    fillWidth          = destinationIsWider ? (int)std::lround(scaledHeight * aspectRatio) : scaledWidth;
-                const int    fillHeight         = destinationIsWider ? scaledHeight : (int)std::lround(scaledWidth / aspectRatio);
-
-                std::memset(bufferDepth8 + destChannels * fillHeight * alignedWidth, 55, destChannels * (scaledHeight - fillHeight) * alignedWidth);
-
-#pragma omp parallel for
-                for (int j = 0; j < fillHeight; j++)
+                else
                 {
-                    unsigned char* dest = bufferDepth8 + (j * alignedWidth + fillWidth) * destChannels;
-
-                    for (int i = fillWidth; i < scaledWidth; i++, ++dest)
-                    {
-                        *dest = 55;
-                    }
+                    ConvertToDepth8(destination, destStride, layout, map, scaling, x, y, w, h, scaledWidth, scaledHeight);
                 }
+            };
 
-#pragma omp parallel for
-                for (int j = 0; j < fillHeight; j++)
+            if (transform.Options().dither)
+            {
+                if (const uint16_t* fixed = transform.FixedTable())
                 {
-                    unsigned char* dest = bufferDepth8 + (j * alignedWidth) * destChannels;
-
-                    for (int i = 0; i < fillWidth; i++, dest += destChannels)
+                    const auto lookup = [fixed](const T val, const int px, const int py)
                     {
-                        int iSrc = x + (int)std::lround(static_cast<double>(i) * w / fillWidth);
-                        int jSrc = y + (int)std::lround(static_cast<double>(j) * h / fillHeight);
+                        return (uint8_t)((fixed[(size_t)val] + detail::DitherThreshold(px, py)) >> 8);
+                    };
 
-                        if (jSrc >= 0 && jSrc < Height() && iSrc >= 0 && iSrc < Width())
-                        {
-                            const T* src = Buffer() + (jSrc * Width() + iSrc) * _channels;
+                    convert(lookup);
+                }
+                else
+                {
+                    const auto& mapping = transform.Mapping();
+                    const auto  dither  = [&mapping](const T val, const int px, const int py)
+                    {
+                        return (uint8_t)((mapping.Fixed(val) + detail::DitherThreshold(px, py)) >> 8);
+                    };
 
-                            if (_channels == 3)
-                            {
-                                dest[0] = CalculateDisplayValue(src[2]); // B
-                                dest[1] = CalculateDisplayValue(src[1]); // G
-                                dest[2] = CalculateDisplayValue(src[0]); // R
-                                dest[3] = 255;                           // A
-                            }
-                            else if (_channels == 4)
-                            {
-                                dest[0] = CalculateDisplayValue(src[3]); // B
-                                dest[1] = CalculateDisplayValue(src[2]); // G
-                                dest[2] = CalculateDisplayValue(src[1]); // R
-                                dest[3] = CalculateDisplayValue(src[0]); // A
-                            }
-                            else
-                            {
-                                dest[0] = CalculateDisplayValue(src[0]);
-                            }
-                        }
-                    }
+                    convert(dither);
                 }
             }
+            else if (const uint8_t* lut = transform.Table())
+            {
+                const auto lookup = [lut](const T val, int, int)
+                {
+                    return lut[(size_t)val];
+                };
 
-            return bufferDepth8;
+                convert(lookup);
+            }
+            else
+            {
+                convert(transform.Mapping());
+            }
         }
 
         std::shared_ptr<BitmapData> AbsoluteDiff(const BitmapData& other)
@@ -1002,31 +1025,347 @@ namespace acrion::image
         }
 
     private:
-        uint8_t CalculateDisplayValue(T val) const
+        /// Evaluates `sample(x, y)` for each of the `count` positions into `out`. The queries are ordered by source
+        /// row with a counting sort, so that each thread walks through the image from top to bottom instead of
+        /// jumping between rows in the order of the caller. An empty image has nothing to sample from.
+        template <typename Result, typename Sample>
+        void SampleBatch(const char* name, const std::pair<double, double>* positions, const size_t count, Result* out, Sample sample) const
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            if (_width <= 0 || _height <= 0)
+            {
+                throw std::runtime_error(std::string("acrion::image::BitmapData::") + name + ": image is empty");
+            }
+
+            const auto row = [this](const double y)
+            {
+                return y >= 0 ? (int)std::min((double)_height - 1, y) : 0; // NaN goes to row 0, too
+            };
+
+            std::vector<size_t> start(_height + 1, 0);
+            for (size_t i = 0; i < count; ++i)
+            {
+                ++start[row(positions[i].second) + 1];
+            }
+
+            for (int y = 0; y < _height; ++y)
+            {
+                start[y + 1] += start[y];
+            }
+
+            std::vector<size_t> order(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                order[start[row(positions[i].second)]++] = i;
+            }
+
+#pragma omp parallel for schedule(static)
+            for (int64_t k = 0; k < (int64_t)count; ++k)
+            {
+                const size_t i = order[k];
+                out[i]         = sample(positions[i].first, positions[i].second);
+            }
+        }
+
+        void WritePixel(const int x, const int y, const Color<T>& color) const
         {
-            val = std::min(std::max(val, _minDisplayedBrightness), _maxDisplayedBrightness);
+            T* ptr = Buffer() + (y * _width + x) * _channels;
 
-            const T diff = val >= _minDisplayedBrightness ? val - _minDisplayedBrightness : 0;
+            if (_grayIndex != -1)
+            {
+                ptr[_grayIndex] = color.Gray();
+            }
+            else
+            {
+                ptr[_redIndex]   = color.Red();
+                ptr[_greenIndex] = color.Green();
+                ptr[_blueIndex]  = color.Blue();
+            }
 
-            const double val0 = 255.0 * diff / (_maxDisplayedBrightness - _minDisplayedBrightness);
+            if (_alphaIndex == -1)
+            {
+                if (color.Alpha() != std::numeric_limits<T>().max())
+                {
+                    throw std::runtime_error("BitmapData::Set: Cannot set alpha channel to " + std::to_string(color.Alpha()) + " in an image with " + std::to_string(_channels) + " channels.");
+                }
+            }
+            else
+            {
+                ptr[_alphaIndex] = color.Alpha();
+            }
+        }
+
+        /// applies the defaults of ConvertToDepth8: w or h <= 0 extend to the image border, scaled sizes <= 0 mean unscaled
+        void ResolveDisplayRegion(const int x, const int y, int& w, int& h, int& scaledWidth, int& scaledHeight) const
+        {
+            if (w <= 0) w = Width() - x;
+            if (h <= 0) h = Height() - y;
+            if (scaledWidth <= 0) scaledWidth = w;
+            if (scaledHeight <= 0) scaledHeight = h;
+        }
 
-            if (_currentGamma == 0)
+        /// Maps n pixels and writes them with destChannels bytes each, red, green, blue and alpha at the given byte
+        /// offsets (alpha < 0: none). With `luma`, colour pixels are reduced to the luma of their mapped values.
+        template <int destChannels, int r, int g, int b, int a, bool luma, typename S, typename Map>
+        static void PackRowToDepth8(const S* src, unsigned char* dest, const int n, const int channels, const Map& map, const int x0, const int y)
+        {
+            if (channels == 1)
             {
-                return (uint8_t)std::max(0l, std::min(255l, std::lround(val0)));
+                for (int i = 0; i < n; i++, src++, dest += destChannels)
+                {
+                    if constexpr (detail::IsPaletteMap<Map>::value)
+                    {
+                        const Colormap::Rgb& color = (*map.colormap)[map(src[0], x0 + i, y)];
+
+                        dest[r] = color[0];
+                        if constexpr (destChannels > 1)
+                        {
+                            dest[g] = color[1];
+                            dest[b] = color[2];
+                        }
+                    }
+                    else
+                    {
+                        const uint8_t gray = map(src[0], x0 + i, y);
+
+                        dest[r] = gray;
+                        if constexpr (destChannels > 1)
+                        {
+                            dest[g] = gray;
+                            dest[b] = gray;
+                        }
+                    }
+                    if constexpr (a >= 0) dest[a] = 255;
+                }
+                return;
             }
 
-            double gamma1 = _currentGamma * 2;
-            if (gamma1 > 1) gamma1 = 1;
+            const int red = channels == 4 ? 1 : 0;
 
-            double       delta  = 9 - _currentGamma * 6;
-            const double log2   = log(2.0);
-            double       factor = 256.0 / (double)(log1p((long double)_maxDisplayedBrightness - _minDisplayedBrightness) / log2 - delta);
+            for (int i = 0; i < n; i++, src += channels, dest += destChannels)
+            {
+                const uint8_t mappedRed   = map(src[red], x0 + i, y);
+                const uint8_t mappedGreen = map(src[red + 1], x0 + i, y);
+                const uint8_t mappedBlue  = map(src[red + 2], x0 + i, y);
+
+                if constexpr (luma)
+                {
+                    const uint8_t gray = (uint8_t)((detail::grayWeightRed * mappedRed + detail::grayWeightGreen * mappedGreen + detail::grayWeightBlue * mappedBlue + 32768) >> 16);
 
-            double result = log((double)val) / log2 - delta; // cppcheck-suppress invalidFunctionArg
-            double val1   = (result <= 0) ? 0 : result * factor;
-            double t      = gamma1 * val1 + (1 - gamma1) * val0;
+                    dest[r] = gray;
+                    if constexpr (destChannels > 1)
+                    {
+                        dest[g] = gray;
+                        dest[b] = gray;
+                    }
+                }
+                else
+                {
+                    dest[r] = mappedRed;
+                    dest[g] = mappedGreen;
+                    dest[b] = mappedBlue;
+                }
 
-            return (uint8_t)std::max(0l, std::min(255l, std::lround(t)));
+                if constexpr (a >= 0) dest[a] = channels == 4 ? map(src[0], x0 + i, y) : 255;
+            }
+        }
+
+        template <typename S, typename Map>
+        static void ConvertRowToDepth8(const S* src, unsigned char* dest, const int n, const int channels, const DisplayLayout layout, const Map& map, const int x0, const int y)
+        {
+            // maps without a table convert the whole row in one vectorised pass before packing
+            constexpr int minRowMapping = 16;
+
+            if constexpr (detail::HasMapRow<Map>::value)
+            {
+                if (n >= minRowMapping)
+                {
+                    thread_local std::vector<uint8_t> mapped;
+                    mapped.resize((size_t)n * channels);
+                    map.MapRow(src, (size_t)n * channels, mapped.data());
+                    ConvertRowToDepth8(mapped.data(), dest, n, channels, layout, detail::IdentityMap{}, x0, y);
+                    return;
+                }
+            }
+
+            if constexpr (detail::IsPaletteMap<Map>::value)
+            {
+                if constexpr (detail::HasMapRow<decltype(map.index)>::value)
+                {
+                    if (n >= minRowMapping)
+                    {
+                        thread_local std::vector<uint8_t> mapped;
+                        mapped.resize((size_t)n * channels);
+                        map.index.MapRow(src, (size_t)n * channels, mapped.data());
+                        ConvertRowToDepth8(mapped.data(), dest, n, channels, layout, detail::PaletteMap<detail::IdentityMap>{{}, map.colormap}, x0, y);
+                        return;
+                    }
+                }
+            }
+
+            switch (layout)
+            {
+            case DisplayLayout::Gray8:
+                PackRowToDepth8<1, 0, 0, 0, -1, true>(src, dest, n, channels, map, x0, y);
+                break;
+            case DisplayLayout::Rgba:
+                PackRowToDepth8<4, 0, 1, 2, 3, false>(src, dest, n, channels, map, x0, y);
+                break;
+            case DisplayLayout::Argb:
+                PackRowToDepth8<4, 1, 2, 3, 0, false>(src, dest, n, channels, map, x0, y);
+                break;
+            case DisplayLayout::Rgb:
+                PackRowToDepth8<3, 0, 1, 2, -1, false>(src, dest, n, channels, map, x0, y);
+                break;
+            case DisplayLayout::GrayAsBgra:
+                PackRowToDepth8<4, 2, 1, 0, 3, true>(src, dest, n, channels, map, x0, y);
+                break;
+            default:
+                PackRowToDepth8<4, 2, 1, 0, 3, false>(src, dest, n, channels, map, x0, y);
+                break;
+            }
+        }
+
+        template <typename Map>
+        void ConvertToDepth8(unsigned char* bufferDepth8, const size_t destStride, const DisplayLayout layout, const Map& map, const ResampleFilter scaling, const int x, const int y, const int w, const int h, const int scaledWidth, const int scaledHeight) const
+        {
+            const size_t destChannels = detail::LayoutChannels(layout);
+
+            if (scaledWidth == w && scaledHeight == h)
+            {
+#pragma omp parallel for
+                for (int j = 0; j < h; j++)
+                {
+                    unsigned char* dest = bufferDepth8 + j * destStride;
+
+                    if (y + j < 0 || y + j >= Height())
+                    {
+                        std::memset(dest, 55, w * destChannels);
+                        continue;
+                    }
+
+                    const int iBegin = std::min(w, std::max(0, -x));
+                    const int iEnd   = std::max(iBegin, std::min(w, Width() - x));
+
+                    std::memset(dest, 55, iBegin * destChannels);
+                    std::memset(dest + iEnd * destChannels, 55, (w - iEnd) * destChannels);
+
+                    const T* src = Buffer() + ((size_t)(y + j) * Width() + x + iBegin) * _channels;
+                    ConvertRowToDepth8(src, dest + iBegin * destChannels, iEnd - iBegin, _channels, layout, map, iBegin, j);
+                }
+            }
+            else
+            {
+                const double aspectRatio        = static_cast<double>(w) / h;
+                const bool   destinationIsWider = static_cast<double>(scaledWidth) / scaledHeight > aspectRatio;
+                const int    fillWidth          = destinationIsWider ? (int)std::lround(scaledHeight * aspectRatio) : scaledWidth;
+                const int    fillHeight         = destinationIsWider ? scaledHeight : (int)std::lround(scaledWidth / aspectRatio);
+
+                for (int j = fillHeight; j < scaledHeight; j++)
+                {
+                    std::memset(bufferDepth8 + j * destStride, 55, scaledWidth * destChannels);
+                }
+
+                const detail::ResampleAxis columns = detail::MakeResampleAxis(scaling, fillWidth, x, w, Width());
+                const detail::ResampleAxis rows    = detail::MakeResampleAxis(scaling, fillHeight, y, h, Height());
+
+                if (scaling == ResampleFilter::Nearest)
+                {
+#pragma omp parallel for
+                    for (int j = 0; j < fillHeight; j++)
+                    {
+                        unsigned char* dest = bufferDepth8 + j * destStride;
+
+                        std::memset(dest + fillWidth * destChannels, 55, (scaledWidth - fillWidth) * destChannels);
+
+                        if (rows.count[j] == 0)
+                        {
+                            std::memset(dest, 55, fillWidth * destChannels);
+                            continue;
+                        }
+
+                        // gather the row, so that it is mapped in one call
+                        const T* src = Buffer() + (size_t)rows.first[j] * Width() * _channels;
+
+                        thread_local std::vector<T> gathered;
+                        gathered.resize((size_t)fillWidth * _channels);
+                        for (int i = 0; i < fillWidth; i++)
+                        {
+                            std::memcpy(gathered.data() + (size_t)i * _channels, src + (size_t)columns.first[i] * _channels, _channels * sizeof(T));
+                        }
+
+                        ConvertRowToDepth8(gathered.data(), dest, fillWidth, _channels, layout, map, 0, j);
+
+                        for (int i = 0; i < fillWidth; i++)
+                        {
+                            if (columns.count[i] == 0)
+                            {
+                                std::memset(dest + i * destChannels, 55, destChannels);
+                            }
+                        }
+                    }
+                    return;
+                }
+
+                // Filter in the source depth first, so that the display mapping only runs on the reduced row.
+                const int                     n          = fillWidth * _channels;
+                const detail::RowTaps<double> columnTaps = detail::MakeRowTaps(columns, columns.weights, _channels, Width());
+
+#pragma omp parallel
+                {
+                    std::vector<double> row(n);
+                    std::vector<double> sum(n);
+                    std::vector<T>      reduced(n);
+
+#pragma omp for
+                    for (int j = 0; j < fillHeight; j++)
+                    {
+                        unsigned char* dest = bufferDepth8 + j * destStride;
+
+                        std::memset(dest + fillWidth * destChannels, 55, (scaledWidth - fillWidth) * destChannels);
+
+                        if (rows.count[j] == 0)
+                        {
+                            std::memset(dest, 55, fillWidth * destChannels);
+                            continue;
+                        }
+
+                        std::fill(sum.begin(), sum.end(), 0.0);
+
+                        const double* weights = rows.weights.data() + rows.offset[j];
+                        for (int t = 0; t < rows.count[j]; t++)
+                        {
+                            detail::ResampleRow(Buffer() + (size_t)(rows.first[j] + t) * Width() * _channels, columnTaps, row.data());
+
+                            const double weight = weights[t];
+#pragma omp simd
+                            for (int k = 0; k < n; k++)
+                            {
+                                sum[k] += weight * row[k];
+                            }
+                        }
+
+                        for (int k = 0; k < n; k++)
+                        {
+                            reduced[k] = detail::ToSample<T>(sum[k]);
+                        }
+
+                        ConvertRowToDepth8(reduced.data(), dest, fillWidth, _channels, layout, map, 0, j);
+
+                        for (int i = 0; i < fillWidth; i++)
+                        {
+                            if (columns.count[i] == 0)
+                            {
+                                std::memset(dest + i * destChannels, 55, destChannels);
+                            }
+                        }
+                    }
+                }
+            }
         }
 
         int                                       _width{0};
@@ -1042,6 +1381,8 @@ namespace acrion::image
 
         T _minDisplayedBrightness{0};
         T _maxDisplayedBrightness{std::numeric_limits<T>::max()};
+
+        mutable std::shared_ptr<ChangeTracker> _changes; // not copied: a copy is a different image
     };
 
     template <typename T>
@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace acrion::image
+{
+    /// Records which tiles of an image changed. Every call to MarkDirty draws a new epoch from a counter and stamps
+    /// it on the touched tiles; caches remember the epoch they last synchronised at and ask which tiles are newer.
+    /// Marking may happen from several threads. Call it after writing the pixels.
+    ///
+    /// Epoch() only reports an epoch once its tiles and those of all earlier epochs are stamped. A cache takes
+    /// Epoch() before it scans the tiles and stores that value afterwards: tiles stamped later by marks still in
+    /// progress are then reported again by the next scan instead of being lost.
+    class ChangeTracker
+    {
+    public:
+        static constexpr int tileSize = 64;
+
+        ChangeTracker(const int width, const int height)
+            : _width(width)
+            , _height(height)
+            , _tilesX((width + tileSize - 1) / tileSize)
+            , _tilesY((height + tileSize - 1) / tileSize)
+            , _tiles(new std::atomic<uint64_t>[(size_t)_tilesX * _tilesY])
+        {
+            for (size_t i = 0; i < (size_t)_tilesX * _tilesY; ++i)
+            {
+                _tiles[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        int Width() const { return _width; }
+        int Height() const { return _height; }
+        int TilesX() const { return _tilesX; }
+        int TilesY() const { return _tilesY; }
+
+        /// The epoch of the most recent completed change, 0 if nothing changed since construction. Callers use the
+        /// value as the snapshot they synchronise to, which MarkDirty takes into account.
+        uint64_t Epoch() const
+        {
+            const uint64_t epoch    = _completed.load(std::memory_order_acquire);
+            uint64_t       observed = _observed.load(std::memory_order_relaxed);
+            while (observed < epoch && !_observed.compare_exchange_weak(observed, epoch, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in MarkDirty
+            return epoch;
+        }
+
+        /// Marks the pixels in the region (x, y, w, h) as changed; the region is clipped to the image. Every call
+        /// costs a sequentially consistent fence, even if the tiles are already marked, so writers of single pixels
+        /// should mark the region they wrote once (see BitmapData::Plot with `invalidate` = false).
+        void MarkDirty(int x, int y, int w, int h)
+        {
+            const int x1 = std::min(_width, x + w);
+            const int y1 = std::min(_height, y + h);
+            x            = std::max(0, x);
+            y            = std::max(0, y);
+
+            if (x1 <= x || y1 <= y)
+            {
+                return;
+            }
+
+            const int tx0 = x / tileSize;
+            const int ty0 = y / tileSize;
+            const int tx1 = (x1 - 1) / tileSize;
+            const int ty1 = (y1 - 1) / tileSize;
+
+            // Tiles stamped with an epoch newer than every snapshot taken so far are still reported to all caches, so
+            // repeated marks (e.g. one per plotted pixel) need not draw a new epoch. The fence orders the pixel writes
+            // before the check, against the fence in Epoch().
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const uint64_t observed = _observed.load(std::memory_order_relaxed);
+            bool           pending  = true;
+            for (int ty = ty0; ty <= ty1 && pending; ++ty)
+            {
+                for (int tx = tx0; tx <= tx1 && pending; ++tx)
+                {
+                    pending = _tiles[(size_t)ty * _tilesX + tx].load(std::memory_order_relaxed) > observed;
+                }
+            }
+
+            if (pending)
+            {
+                return;
+            }
+
+            const uint64_t epoch = _epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+            for (int ty = ty0; ty <= ty1; ++ty)
+            {
+                for (int tx = tx0; tx <= tx1; ++tx)
+                {
+                    std::atomic<uint64_t>& tile    = _tiles[(size_t)ty * _tilesX + tx];
+                    uint64_t               current = tile.load(std::memory_order_relaxed);
+                    while (current < epoch && !tile.compare_exchange_weak(current, epoch, std::memory_order_release, std::memory_order_relaxed))
+                    {
+                    }
+                }
+            }
+
+            // publish in order: wait until all earlier marks have finished stamping
+            uint64_t previous = epoch - 1;
+            while (!_completed.compare_exchange_weak(previous, epoch, std::memory_order_release, std::memory_order_relaxed))
+            {
+                previous = epoch - 1;
+                std::this_thread::yield();
+            }
+        }
+
+        void MarkAll() { MarkDirty(0, 0, _width, _height); }
+
+        bool TileChangedSince(const int tx, const int ty, const uint64_t epoch) const
+        {
+            return _tiles[(size_t)ty * _tilesX + tx].load(std::memory_order_acquire) > epoch;
+        }
+
+        /// whether any tile overlapping the pixel region (x, y, w, h) changed after `epoch`
+        bool ChangedSince(const uint64_t epoch, const int x, const int y, const int w, const int h) const
+        {
+            if (_epoch.load(std::memory_order_acquire) <= epoch) // no mark started after `epoch`
+            {
+                return false;
+            }
+
+            const int tx0 = std::max(0, x / tileSize);
+            const int ty0 = std::max(0, y / tileSize);
+            const int tx1 = std::min(_tilesX - 1, (x + w - 1) / tileSize);
+            const int ty1 = std::min(_tilesY - 1, (y + h - 1) / tileSize);
+
+            for (int ty = ty0; ty <= ty1; ++ty)
+            {
+                for (int tx = tx0; tx <= tx1; ++tx)
+                {
+                    if (TileChangedSince(tx, ty, epoch))
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        /// Computes the pixel bounding box of all tiles changed after `epoch`. Returns false if there are none.
+        bool ChangedBounds(const uint64_t epoch, int& x, int& y, int& w, int& h) const
+        {
+            if (_epoch.load(std::memory_order_acquire) <= epoch) // no mark started after `epoch`
+            {
+                return false;
+            }
+
+            int tx0 = _tilesX;
+            int ty0 = _tilesY;
+            int tx1 = -1;
+            int ty1 = -1;
+
+            for (int ty = 0; ty < _tilesY; ++ty)
+            {
+                for (int tx = 0; tx < _tilesX; ++tx)
+                {
+                    if (TileChangedSince(tx, ty, epoch))
+                    {
+                        tx0 = std::min(tx0, tx);
+                        ty0 = std::min(ty0, ty);
+                        tx1 = std::max(tx1, tx);
+                        ty1 = std::max(ty1, ty);
+                    }
+                }
+            }
+
+            if (tx1 < 0)
+            {
+                return false;
+            }
+
+            x = tx0 * tileSize;
+            y = ty0 * tileSize;
+            w = std::min(_width, (tx1 + 1) * tileSize) - x;
+            h = std::min(_height, (ty1 + 1) * tileSize) - y;
+            return true;
+        }
+
+    private:
+        int                                      _width;
+        int                                      _height;
+        int                                      _tilesX;
+        int                                      _tilesY;
+        std::atomic<uint64_t>                    _epoch{0};     // last epoch drawn by MarkDirty
+        std::atomic<uint64_t>                    _completed{0}; // last epoch whose marks and all earlier ones finished
+        mutable std::atomic<uint64_t>            _observed{0};  // largest epoch returned by Epoch()
+        std::unique_ptr<std::atomic<uint64_t>[]> _tiles;
+    };
+}
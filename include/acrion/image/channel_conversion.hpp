@@ -0,0 +1,279 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        /// converts interleaved pixels with `srcChannels` channels, red at `redIndex`, to gray
+        template <typename T>
+        void GrayRow(const T* src, T* dest, const int width, const int srcChannels, const int redIndex)
+        {
+            const T* red   = src + redIndex;
+            const T* green = red + 1;
+            const T* blue  = red + 2;
+
+            if constexpr (std::is_floating_point_v<T>)
+            {
+#pragma omp simd
+                for (int i = 0; i < width; ++i)
+                {
+                    dest[i] = 0.299 * red[i * srcChannels] + 0.587 * green[i * srcChannels] + 0.114 * blue[i * srcChannels];
+                }
+            }
+            else if constexpr (sizeof(T) <= 2)
+            {
+#pragma omp simd
+                for (int i = 0; i < width; ++i)
+                {
+                    dest[i] = (T)((grayWeightRed * (uint32_t)red[i * srcChannels]
+                                   + grayWeightGreen * (uint32_t)green[i * srcChannels]
+                                   + grayWeightBlue * (uint32_t)blue[i * srcChannels]
+                                   + 32768)
+                                  >> 16);
+                }
+            }
+            else if constexpr (sizeof(T) == 4)
+            {
+                // the same arithmetic as Color::Gray; adding 0.5 and truncating equals llround for non-negative values
+#pragma omp simd
+                for (int i = 0; i < width; ++i)
+                {
+                    dest[i] = (T)(0.299 * red[i * srcChannels] + 0.587 * green[i * srcChannels] + 0.114 * blue[i * srcChannels] + 0.5);
+                }
+            }
+            else // 64 bit samples exceed the precision of double
+            {
+                for (int i = 0; i < width; ++i)
+                {
+                    dest[i] = Color<T>(red[i * srcChannels], green[i * srcChannels], blue[i * srcChannels]).Gray();
+                }
+            }
+        }
+
+        inline void CheckChannelConversion(const int srcWidth, const int srcHeight, const int srcChannels, const int expectedSrcChannels, const int destWidth, const int destHeight, const int destChannels, const int expectedDestChannels, const char* function)
+        {
+            if (srcChannels != expectedSrcChannels || destChannels != expectedDestChannels)
+            {
+                throw std::runtime_error(std::string("acrion::image::") + function + ": expected " + std::to_string(expectedSrcChannels) + " source and " + std::to_string(expectedDestChannels) + " destination channels, got " + std::to_string(srcChannels) + " and " + std::to_string(destChannels));
+            }
+
+            if (srcWidth != destWidth || srcHeight != destHeight)
+            {
+                throw std::runtime_error(std::string("acrion::image::") + function + ": destination image has different size");
+            }
+        }
+    }
+
+    /// Computes the luma of an RGB or ARGB image into a single channel image (alpha is ignored).
+    /// Unlike Color::Gray, floating point images keep the fractional part of the luma.
+    template <typename T>
+    void ConvertToGray(const BitmapData<T>& source, BitmapData<T>& destination)
+    {
+        const int channels = source.Channels();
+        detail::CheckChannelConversion(source.Width(), source.Height(), channels, channels == 4 ? 4 : 3, destination.Width(), destination.Height(), destination.Channels(), 1, "ConvertToGray");
+
+        const int redIndex = channels == 4 ? 1 : 0;
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            detail::GrayRow(source.Buffer() + (size_t)y * source.Width() * channels, destination.Buffer() + (size_t)y * destination.Width(), source.Width(), channels, redIndex);
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    /// Drops the alpha channel of an ARGB image.
+    template <typename T>
+    void ConvertArgbToRgb(const BitmapData<T>& source, BitmapData<T>& destination)
+    {
+        detail::CheckChannelConversion(source.Width(), source.Height(), source.Channels(), 4, destination.Width(), destination.Height(), destination.Channels(), 3, "ConvertArgbToRgb");
+
+        const int width = source.Width();
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            const T* src  = source.Buffer() + (size_t)y * width * 4;
+            T*       dest = destination.Buffer() + (size_t)y * width * 3;
+
+#pragma omp simd
+            for (int i = 0; i < width; ++i)
+            {
+                dest[i * 3 + 0] = src[i * 4 + 1];
+                dest[i * 3 + 1] = src[i * 4 + 2];
+                dest[i * 3 + 2] = src[i * 4 + 3];
+            }
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    /// Adds a constant alpha channel to an RGB image.
+    template <typename T>
+    void ConvertRgbToArgb(const BitmapData<T>& source, BitmapData<T>& destination, const T alpha = std::numeric_limits<T>::max())
+    {
+        detail::CheckChannelConversion(source.Width(), source.Height(), source.Channels(), 3, destination.Width(), destination.Height(), destination.Channels(), 4, "ConvertRgbToArgb");
+
+        const int width = source.Width();
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            const T* src  = source.Buffer() + (size_t)y * width * 3;
+            T*       dest = destination.Buffer() + (size_t)y * width * 4;
+
+#pragma omp simd
+            for (int i = 0; i < width; ++i)
+            {
+                dest[i * 4 + 0] = alpha;
+                dest[i * 4 + 1] = src[i * 3 + 0];
+                dest[i * 4 + 2] = src[i * 3 + 1];
+                dest[i * 4 + 3] = src[i * 3 + 2];
+            }
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    /// Broadcasts a gray image into RGB (3 channels) or ARGB (4 channels, opaque).
+    template <typename T>
+    void ConvertGrayToRgb(const BitmapData<T>& source, BitmapData<T>& destination)
+    {
+        const int destChannels = destination.Channels();
+        detail::CheckChannelConversion(source.Width(), source.Height(), source.Channels(), 1, destination.Width(), destination.Height(), destChannels, destChannels == 4 ? 4 : 3, "ConvertGrayToRgb");
+
+        const int width = source.Width();
+        const int first = destChannels - 3;
+        const T   alpha = std::numeric_limits<T>::max();
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            const T* src  = source.Buffer() + (size_t)y * width;
+            T*       dest = destination.Buffer() + (size_t)y * width * destChannels;
+
+            if (first == 1)
+            {
+#pragma omp simd
+                for (int i = 0; i < width; ++i)
+                {
+                    dest[i * 4] = alpha;
+                }
+            }
+
+#pragma omp simd
+            for (int i = 0; i < width; ++i)
+            {
+                dest[i * destChannels + first]     = src[i];
+                dest[i * destChannels + first + 1] = src[i];
+                dest[i * destChannels + first + 2] = src[i];
+            }
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    /// Writes the pixels of an ARGB image in BGRA order to `destination`, which must hold Width() * Height() * 4 samples.
+    /// The result is meant to be handed to external consumers; BitmapData itself always interprets 4 channels as ARGB.
+    template <typename T>
+    void SwizzleArgbToBgra(const BitmapData<T>& source, T* destination)
+    {
+        if (source.Channels() != 4)
+        {
+            throw std::runtime_error("acrion::image::SwizzleArgbToBgra: expected 4 source channels, got " + std::to_string(source.Channels()));
+        }
+
+        const int width = source.Width();
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            const T* src  = source.Buffer() + (size_t)y * width * 4;
+            T*       dest = destination + (size_t)y * width * 4;
+
+#pragma omp simd
+            for (int i = 0; i < width; ++i)
+            {
+                dest[i * 4 + 0] = src[i * 4 + 3];
+                dest[i * 4 + 1] = src[i * 4 + 2];
+                dest[i * 4 + 2] = src[i * 4 + 1];
+                dest[i * 4 + 3] = src[i * 4 + 0];
+            }
+        }
+    }
+
+    /// Converts between gray (1), RGB (3) and ARGB (4) images of equal size, picking the matching kernel above.
+    template <typename T>
+    void ConvertChannels(const BitmapData<T>& source, BitmapData<T>& destination)
+    {
+        const int from = source.Channels();
+        const int to   = destination.Channels();
+
+        if (from == to)
+        {
+            source.Copy(destination);
+        }
+        else if (to == 1)
+        {
+            ConvertToGray(source, destination);
+        }
+        else if (from == 1)
+        {
+            ConvertGrayToRgb(source, destination);
+        }
+        else if (from == 4)
+        {
+            ConvertArgbToRgb(source, destination);
+        }
+        else
+        {
+            ConvertRgbToArgb(source, destination);
+        }
+    }
+
+    template <typename T>
+    BitmapData<T> ConvertChannels(const BitmapData<T>& source, const int channels)
+    {
+        BitmapData<T> destination(source.Width(), source.Height(), channels);
+        ConvertChannels(source, destination);
+        return destination;
+    }
+}
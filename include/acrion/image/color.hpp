@@ -28,14 +28,26 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 #include "utility.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <limits>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace acrion::image
 {
+    namespace detail
+    {
+        // Luma weights 0.299, 0.587 and 0.114 (see Color::Gray) in 16 bit fixed point, for 8 and 16 bit samples only.
+        // They sum up to exactly 65536, so gray input stays unchanged, and results for these depths differ by at most
+        // 1 from Color::Gray. Their relative error (up to 6e-6) is too large for wider samples.
+        constexpr uint32_t grayWeightRed   = 19595;
+        constexpr uint32_t grayWeightGreen = 38470;
+        constexpr uint32_t grayWeightBlue  = 7471;
+    }
+
     template <typename T>
     class Color
     {
@@ -111,29 +123,21 @@ namespace acrion::image
 
         Color<T> Mix(const std::vector<std::tuple<double, Color<T>>>& colors) const
         {
-            long double sumW = 0;
-            long double sumR = 0;
-            long double sumG = 0;
-            long double sumB = 0;
-            long double sumA = 0;
-
-            for (const auto& current : colors)
-            {
-                const long double weight = std::get<0>(current);
-                const Color&      color  = std::get<1>(current);
-                sumW += weight;
-                sumR += weight * color.Red();
-                sumG += weight * color.Green();
-                sumB += weight * color.Blue();
-                sumA += weight * color.Alpha();
-            }
+            return MixRange(colors.begin(), colors.end());
+        }
 
-            const long double weight = std::max(0.0l, std::min(1.0l, 1 - sumW));
+        /// same as above for a fixed number of colours, without heap allocation
+        template <size_t N>
+        Color<T> Mix(const std::array<std::tuple<double, Color<T>>, N>& colors) const
+        {
+            return MixRange(colors.begin(), colors.end());
+        }
 
-            return Color<T>(utility::Convert<T>(weight * Red() + sumR),
-                            utility::Convert<T>(weight * Green() + sumG),
-                            utility::Convert<T>(weight * Blue() + sumB),
-                            utility::Convert<T>(weight * Alpha() + sumA));
+        /// same as above with the pairs as arguments: a.Mix(0.25, b, 0.5, c)
+        template <typename... Rest>
+        Color<T> Mix(const double weight, const Color<T>& color, const Rest&... rest) const
+        {
+            return Mix(utility::Weighted<Color<T>>(weight, color, rest...));
         }
 
         Color& operator+=(long double rhs) // compound assignment (does not need to be a member,
@@ -219,6 +223,93 @@ namespace acrion::image
         // }
 
     private:
+        template <typename Iterator>
+        Color<T> MixRange(const Iterator begin, const Iterator end) const
+        {
+            if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>)
+            {
+                // Weights in 32.32 fixed point, truncated, so each term is off by less than 2^16 units of 2^-32.
+                // Unless a sum lies within that error of a rounding boundary, it rounds like the long double sum
+                // below; otherwise that one decides, so the result is always identical. Weights outside [-1, 1]
+                // or long lists take the general path, which cannot overflow.
+                constexpr double  one  = 4294967296.0;
+                constexpr int64_t half = int64_t(1) << 31;
+                constexpr int64_t mask = (int64_t(1) << 32) - 1;
+
+                double  sumW  = 0;
+                int64_t sumR  = 0;
+                int64_t sumG  = 0;
+                int64_t sumB  = 0;
+                int64_t sumA  = 0;
+                int     count = 0;
+
+                Iterator current = begin;
+                for (; current != end; ++current)
+                {
+                    const double weight = std::get<0>(*current);
+                    if (!(std::abs(weight) <= 1.0) || ++count > 4096)
+                    {
+                        break;
+                    }
+
+                    const int64_t fixed = (int64_t)(weight * one);
+                    const Color&  color = std::get<1>(*current);
+                    sumW += weight;
+                    sumR += fixed * color.Red();
+                    sumG += fixed * color.Green();
+                    sumB += fixed * color.Blue();
+                    sumA += fixed * color.Alpha();
+                }
+
+                if (current == end)
+                {
+                    const int64_t weight = (int64_t)(std::max(0.0, std::min(1.0, 1 - sumW)) * one);
+                    const int64_t bound  = (int64_t)(count + 2) << 17; // twice the error of count + 1 terms
+                    const int64_t red    = weight * Red() + sumR;
+                    const int64_t green  = weight * Green() + sumG;
+                    const int64_t blue   = weight * Blue() + sumB;
+                    const int64_t alpha  = weight * Alpha() + sumA;
+
+                    const auto clear = [bound](const int64_t sum)
+                    {
+                        return std::abs((sum & mask) - half) > bound;
+                    };
+
+                    if (clear(red) && clear(green) && clear(blue) && clear(alpha))
+                    {
+                        return Color<T>(static_cast<T>((red + half) >> 32),
+                                        static_cast<T>((green + half) >> 32),
+                                        static_cast<T>((blue + half) >> 32),
+                                        static_cast<T>((alpha + half) >> 32));
+                    }
+                }
+            }
+
+            long double sumW = 0;
+            long double sumR = 0;
+            long double sumG = 0;
+            long double sumB = 0;
+            long double sumA = 0;
+
+            for (Iterator current = begin; current != end; ++current)
+            {
+                const long double weight = std::get<0>(*current);
+                const Color&      color  = std::get<1>(*current);
+                sumW += weight;
+                sumR += weight * color.Red();
+                sumG += weight * color.Green();
+                sumB += weight * color.Blue();
+                sumA += weight * color.Alpha();
+            }
+
+            const long double weight = std::max(0.0l, std::min(1.0l, 1 - sumW));
+
+            return Color<T>(utility::Convert<T>(weight * Red() + sumR),
+                            utility::Convert<T>(weight * Green() + sumG),
+                            utility::Convert<T>(weight * Blue() + sumB),
+                            utility::Convert<T>(weight * Alpha() + sumA));
+        }
+
         T _red{std::numeric_limits<T>::min()};
         T _green{std::numeric_limits<T>::min()};
         T _blue{std::numeric_limits<T>::min()};
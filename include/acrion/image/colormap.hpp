@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+namespace acrion::image
+{
+    /// A palette of 256 RGB colours that replaces the gray display value of single channel images (false colour).
+    class Colormap
+    {
+    public:
+        using Rgb = std::array<uint8_t, 3>;
+
+        explicit Colormap(const std::array<Rgb, 256>& colors)
+            : _colors(colors)
+        {
+        }
+
+        /// Samples `f(double t)`, which returns red, green and blue in [0, 1] for t in [0, 1].
+        template <typename Function>
+        static Colormap FromFunction(Function f)
+        {
+            std::array<Rgb, 256> colors{};
+            for (int i = 0; i < 256; ++i)
+            {
+                const std::array<double, 3> rgb = f(i / 255.0);
+                for (int k = 0; k < 3; ++k)
+                {
+                    colors[i][k] = (uint8_t)std::lround(255.0 * std::min(1.0, std::max(0.0, rgb[k])));
+                }
+            }
+            return Colormap(colors);
+        }
+
+        /// perceptually uniform blue - green - yellow (matplotlib's viridis, polynomial fit)
+        static std::shared_ptr<const Colormap> Viridis()
+        {
+            static const auto colormap = std::make_shared<const Colormap>(FromFunction([](const double t)
+            {
+                return Polynomial(t,
+                                  {{{0.2777273272234177, 0.005407344544966578, 0.3340998053353061},
+                                    {0.1050930431085774, 1.404613529898575, 1.384590162594685},
+                                    {-0.3308618287255563, 0.214847559468213, 0.09509516302823659},
+                                    {-4.634230498983486, -5.799100973351585, -19.33244095627987},
+                                    {6.228269936347081, 14.17993336680509, 56.69055260068105},
+                                    {4.776384997670288, -13.74514537774601, -65.35303263337234},
+                                    {-5.435455855934631, 4.645852612178535, 26.3124352495832}}});
+            }));
+            return colormap;
+        }
+
+        /// perceptually uniform black - red - yellow - white (matplotlib's inferno, polynomial fit)
+        static std::shared_ptr<const Colormap> Inferno()
+        {
+            static const auto colormap = std::make_shared<const Colormap>(FromFunction([](const double t)
+            {
+                return Polynomial(t,
+                                  {{{0.0002189403691192265, 0.001651004631001012, -0.01948089843709184},
+                                    {0.1065134194856116, 0.5639564367884091, 3.932712388889277},
+                                    {11.60249308247187, -3.972853965665698, -15.9423941062914},
+                                    {-41.70399613139459, 17.43639888205313, 44.35414519872813},
+                                    {77.162935699427, -33.40235894210092, -81.80730925738993},
+                                    {-71.31942824499214, 32.62606426397723, 73.20951985803202},
+                                    {25.13112622477341, -12.24266895238567, -23.07032500287172}}});
+            }));
+            return colormap;
+        }
+
+        /// blue - cyan - yellow - red
+        static std::shared_ptr<const Colormap> Jet()
+        {
+            static const auto colormap = std::make_shared<const Colormap>(FromFunction([](const double t)
+            {
+                return std::array<double, 3>{1.5 - std::abs(4 * t - 3), 1.5 - std::abs(4 * t - 2), 1.5 - std::abs(4 * t - 1)};
+            }));
+            return colormap;
+        }
+
+        const Rgb& operator[](const uint8_t index) const { return _colors[index]; }
+
+        bool operator==(const Colormap& other) const { return _colors == other._colors; }
+        bool operator!=(const Colormap& other) const { return !operator==(other); }
+
+    private:
+        /// evaluates c[0] + c[1] t + ... + c[6] t^6 per colour channel
+        static std::array<double, 3> Polynomial(const double t, const std::array<std::array<double, 3>, 7>& c)
+        {
+            std::array<double, 3> result{};
+            for (int k = 0; k < 3; ++k)
+            {
+                for (int i = 6; i >= 0; --i)
+                {
+                    result[k] = result[k] * t + c[i][k];
+                }
+            }
+            return result;
+        }
+
+        std::array<Rgb, 256> _colors;
+    };
+}
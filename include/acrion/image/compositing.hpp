@@ -0,0 +1,242 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "depth_conversion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace acrion::image
+{
+    /// Porter-Duff operators, applied to every channel including alpha (s = source, d = destination, premultiplied).
+    /// Alpha is opaque at the maximum of integer sample types and at 1 for floating point samples, whose colour
+    /// channels are not clamped.
+    enum class CompositeOperation
+    {
+        Over,    // s + d * (1 - alpha_s)
+        In,      // s * alpha_d
+        Out,     // s * (1 - alpha_d)
+        Add,     // s + d, saturated
+        Multiply // s * d + s * (1 - alpha_d) + d * (1 - alpha_s)
+    };
+
+    namespace detail
+    {
+        /// the alpha value of an opaque pixel: max(T) for integer samples, 1 for floating point samples
+        template <typename T>
+        constexpr T Opaque()
+        {
+            return std::is_floating_point_v<T> ? T(1) : std::numeric_limits<T>::max();
+        }
+
+        /// a * b / Opaque<T>(), rounded; exact integer arithmetic for 8 and 16 bit samples
+        template <typename T>
+        inline T MulNormalized(const T a, const T b)
+        {
+            if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>)
+            {
+                constexpr int  bits = sizeof(T) * 8;
+                const uint32_t t    = (uint32_t)a * b + (1u << (bits - 1));
+                return (T)((t + (t >> bits)) >> bits);
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                return a * b;
+            }
+            else
+            {
+                return (T)std::floor((double)a * ((double)b / (double)std::numeric_limits<T>::max()) + 0.5);
+            }
+        }
+
+        template <typename T>
+        inline T AddSaturated(const T a, const T b)
+        {
+            return a > std::numeric_limits<T>::max() - b ? std::numeric_limits<T>::max() : (T)(a + b);
+        }
+
+        template <typename T>
+        void CompositeRow(T* d, const T* s, const int n, const CompositeOperation operation)
+        {
+            constexpr T max = Opaque<T>();
+
+            switch (operation)
+            {
+            case CompositeOperation::Over:
+#pragma omp simd
+                for (int i = 0; i < n; ++i)
+                {
+                    const T inverseAlpha = max - s[i & ~3];
+                    d[i]                 = AddSaturated(s[i], MulNormalized(d[i], inverseAlpha));
+                }
+                break;
+            case CompositeOperation::In:
+                for (int i = 0; i < n; i += 4)
+                {
+                    const T alphaD = d[i];
+
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        d[i + k] = MulNormalized(s[i + k], alphaD);
+                    }
+                }
+                break;
+            case CompositeOperation::Out:
+                for (int i = 0; i < n; i += 4)
+                {
+                    const T inverseAlphaD = max - d[i];
+
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        d[i + k] = MulNormalized(s[i + k], inverseAlphaD);
+                    }
+                }
+                break;
+            case CompositeOperation::Add:
+#pragma omp simd
+                for (int i = 0; i < n; ++i)
+                {
+                    d[i] = AddSaturated(s[i], d[i]);
+                }
+                break;
+            case CompositeOperation::Multiply:
+                for (int i = 0; i < n; i += 4)
+                {
+                    const T alphaS = s[i];
+                    const T alphaD = d[i];
+
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        const T product = MulNormalized(s[i + k], d[i + k]);
+                        const T s1      = MulNormalized(s[i + k], (T)(max - alphaD));
+                        const T d1      = MulNormalized(d[i + k], (T)(max - alphaS));
+                        d[i + k]        = AddSaturated(AddSaturated(product, s1), d1);
+                    }
+                }
+                break;
+            }
+        }
+
+        inline void CheckArgb(const int channels, const char* function)
+        {
+            if (channels != 4)
+            {
+                throw std::runtime_error(std::string("acrion::image::") + function + ": expected an ARGB image with 4 channels, got " + std::to_string(channels));
+            }
+        }
+    }
+
+    /// Converts an ARGB image with straight alpha to premultiplied alpha, as expected by Composite.
+    template <typename T>
+    void Premultiply(BitmapData<T>& image)
+    {
+        detail::CheckArgb(image.Channels(), "Premultiply");
+
+        const int n = image.Width() * 4;
+
+#pragma omp parallel for
+        for (int y = 0; y < image.Height(); ++y)
+        {
+            T* p = image.Buffer() + (size_t)y * n;
+
+#pragma omp simd
+            for (int i = 0; i < n; ++i)
+            {
+                if ((i & 3) != 0)
+                {
+                    p[i] = detail::MulNormalized(p[i], p[i & ~3]);
+                }
+            }
+        }
+
+        image.Invalidate();
+    }
+
+    /// Converts an ARGB image with premultiplied alpha back to straight alpha. Fully transparent pixels become black.
+    template <typename T>
+    void Unpremultiply(BitmapData<T>& image)
+    {
+        detail::CheckArgb(image.Channels(), "Unpremultiply");
+
+        const int    n   = image.Width() * 4;
+        const double max = std::is_floating_point_v<T> ? std::numeric_limits<double>::max() : detail::MaxConvertible<T>();
+
+#pragma omp parallel for
+        for (int y = 0; y < image.Height(); ++y)
+        {
+            T* p = image.Buffer() + (size_t)y * n;
+
+#pragma omp simd
+            for (int i = 0; i < n; ++i)
+            {
+                if ((i & 3) != 0)
+                {
+                    const double alpha = (double)p[i & ~3];
+                    const double v     = alpha > 0 ? std::min(max, (double)p[i] * ((double)detail::Opaque<T>() / alpha)) : 0.0;
+                    p[i]               = std::is_floating_point_v<T> ? (T)v : (T)std::floor(v + 0.5);
+                }
+            }
+        }
+
+        image.Invalidate();
+    }
+
+    /// Composites the premultiplied ARGB `source` onto the premultiplied ARGB `destination`, with the top left
+    /// corner of `source` at (x, y). Parts of `source` outside `destination` are ignored.
+    template <typename T>
+    void Composite(BitmapData<T>& destination, const BitmapData<T>& source, const int x, const int y, const CompositeOperation operation = CompositeOperation::Over)
+    {
+        detail::CheckArgb(destination.Channels(), "Composite");
+        detail::CheckArgb(source.Channels(), "Composite");
+
+        const int x0 = std::max(0, x);
+        const int y0 = std::max(0, y);
+        const int x1 = std::min(destination.Width(), x + source.Width());
+        const int y1 = std::min(destination.Height(), y + source.Height());
+
+        if (x1 <= x0 || y1 <= y0)
+        {
+            return;
+        }
+
+#pragma omp parallel for
+        for (int j = y0; j < y1; ++j)
+        {
+            T*       d = destination.Buffer() + ((size_t)j * destination.Width() + x0) * 4;
+            const T* s = source.Buffer() + ((size_t)(j - y) * source.Width() + (x0 - x)) * 4;
+            detail::CompositeRow(d, s, (x1 - x0) * 4, operation);
+        }
+
+        destination.Invalidate(x0, y0, x1 - x0, y1 - y0);
+    }
+}
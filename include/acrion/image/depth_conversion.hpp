@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace acrion::image
+{
+    enum class Rounding
+    {
+        Nearest,   // half away from zero, like std::llround
+        Down,      // towards negative infinity
+        TowardZero // plain truncation
+    };
+
+    /// Describes the mapping `destination = source * scale + offset` applied by ConvertDepth.
+    /// With `saturate` set, results are clamped to the range of the destination type; without it,
+    /// the caller guarantees that all results fit and out-of-range values yield unspecified results. NaN converts
+    /// to 0 in integer destinations.
+    struct DepthConversion
+    {
+        double   scale{1.0};
+        double   offset{0.0};
+        Rounding rounding{Rounding::Nearest};
+        bool     saturate{true};
+
+        bool IsIdentity() const { return scale == 1.0 && offset == 0.0; }
+
+        /// linear mapping of [sourceMin, sourceMax] onto [destinationMin, destinationMax]
+        static DepthConversion Range(double sourceMin, double sourceMax, double destinationMin, double destinationMax)
+        {
+            DepthConversion conversion;
+            conversion.scale  = sourceMax != sourceMin ? (destinationMax - destinationMin) / (sourceMax - sourceMin) : 1.0;
+            conversion.offset = destinationMin - sourceMin * conversion.scale;
+            return conversion;
+        }
+
+        /// maps the full range of integer type T onto the full range of integer type U, e.g. 65535 to 255
+        template <typename T, typename U>
+        static DepthConversion FullRange()
+        {
+            static_assert(std::numeric_limits<T>::is_integer && std::numeric_limits<U>::is_integer, "DepthConversion::FullRange requires integer types");
+            return Range(0.0, (double)std::numeric_limits<T>::max(), 0.0, (double)std::numeric_limits<U>::max());
+        }
+    };
+
+    namespace detail
+    {
+        /// largest double that can be converted to U without overflow (2^64 - 2048 for uint64_t)
+        template <typename U>
+        double MaxConvertible()
+        {
+            const double max = (double)std::numeric_limits<U>::max();
+            return max >= std::ldexp(1.0, std::numeric_limits<U>::digits) ? std::nextafter(max, 0.0) : max;
+        }
+
+        /// `v` clamped to [lower, upper] for the conversion to an integer type, with NaN mapped to 0; a branch-free
+        /// select, so the row loops still vectorise
+        inline double Convertible(const double v, const double lower, const double upper)
+        {
+            return v == v ? std::min(std::max(v, lower), upper) : 0.0;
+        }
+
+        template <typename T, typename U>
+        constexpr bool IsLossless()
+        {
+            if constexpr (std::is_same_v<T, U>)
+            {
+                return true;
+            }
+            else if constexpr (std::is_floating_point_v<U>)
+            {
+                return std::numeric_limits<T>::digits <= std::numeric_limits<U>::digits;
+            }
+            else
+            {
+                return std::numeric_limits<T>::is_integer && sizeof(T) < sizeof(U);
+            }
+        }
+
+        template <typename T, typename U>
+        void ConvertDepthRow(const T* src, U* dest, const int n, const DepthConversion& conversion)
+        {
+            if constexpr (IsLossless<T, U>())
+            {
+                if (conversion.IsIdentity())
+                {
+                    if constexpr (std::is_same_v<T, U>)
+                    {
+                        std::memcpy(dest, src, n * sizeof(T));
+                    }
+                    else
+                    {
+#pragma omp simd
+                        for (int i = 0; i < n; ++i)
+                        {
+                            dest[i] = (U)src[i];
+                        }
+                    }
+                    return;
+                }
+            }
+
+            if constexpr (std::numeric_limits<T>::is_integer && std::numeric_limits<U>::is_integer)
+            {
+                if (conversion.IsIdentity()) // narrowing integer conversion does not need floating point
+                {
+                    if (conversion.saturate)
+                    {
+                        const T max = (T)std::numeric_limits<U>::max();
+#pragma omp simd
+                        for (int i = 0; i < n; ++i)
+                        {
+                            dest[i] = (U)std::min(src[i], max);
+                        }
+                    }
+                    else
+                    {
+#pragma omp simd
+                        for (int i = 0; i < n; ++i)
+                        {
+                            dest[i] = (U)src[i];
+                        }
+                    }
+                    return;
+                }
+            }
+
+            const double scale  = conversion.scale;
+            const double offset = conversion.offset;
+
+            if constexpr (std::is_floating_point_v<U>)
+            {
+#pragma omp simd
+                for (int i = 0; i < n; ++i)
+                {
+                    dest[i] = (U)((double)src[i] * scale + offset);
+                }
+            }
+            else
+            {
+                // Clamping first turns rounding into floor(v + 0.5), which equals std::llround for non-negative values
+                // and vectorizes, while std::llround does not.
+                const double lower = conversion.saturate ? 0.0 : std::numeric_limits<double>::lowest();
+                const double upper = conversion.saturate ? MaxConvertible<U>() : std::numeric_limits<double>::max();
+
+                switch (conversion.rounding)
+                {
+                case Rounding::Nearest:
+#pragma omp simd
+                    for (int i = 0; i < n; ++i)
+                    {
+                        dest[i] = (U)std::floor(Convertible((double)src[i] * scale + offset, lower, upper) + 0.5);
+                    }
+                    break;
+                case Rounding::Down:
+#pragma omp simd
+                    for (int i = 0; i < n; ++i)
+                    {
+                        dest[i] = (U)std::floor(Convertible((double)src[i] * scale + offset, lower, upper));
+                    }
+                    break;
+                case Rounding::TowardZero:
+#pragma omp simd
+                    for (int i = 0; i < n; ++i)
+                    {
+                        dest[i] = (U)Convertible((double)src[i] * scale + offset, lower, upper);
+                    }
+                    break;
+                }
+            }
+        }
+
+        template <typename T, typename U>
+        U ConvertDepthValue(const T val, const DepthConversion& conversion)
+        {
+            U result;
+            ConvertDepthRow(&val, &result, 1, conversion);
+            return result;
+        }
+    }
+
+    /// Converts every sample of `source` into the element type of `destination`, which must have the same geometry.
+    /// The displayed brightness range is mapped along, so that the converted image displays like the source.
+    template <typename T, typename U>
+    void ConvertDepth(const BitmapData<T>& source, BitmapData<U>& destination, const DepthConversion& conversion = {})
+    {
+        if (source.Width() != destination.Width() || source.Height() != destination.Height() || source.Channels() != destination.Channels())
+        {
+            throw std::runtime_error("acrion::image::ConvertDepth: destination image has different geometry");
+        }
+
+        const int rowLength = source.Width() * source.Channels();
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            detail::ConvertDepthRow(source.Buffer() + (size_t)y * rowLength, destination.Buffer() + (size_t)y * rowLength, rowLength, conversion);
+        }
+
+        DepthConversion displayConversion = conversion;
+        displayConversion.saturate        = true;
+        destination.SetBrightnessRangeForDisplay(detail::ConvertDepthValue<T, U>(source.GetMinDisplayedBrightness(), displayConversion),
+                                                 detail::ConvertDepthValue<T, U>(source.GetMaxDisplayedBrightness(), displayConversion));
+        destination.Invalidate();
+    }
+
+    template <typename U, typename T>
+    BitmapData<U> ConvertDepth(const BitmapData<T>& source, const DepthConversion& conversion = {})
+    {
+        BitmapData<U> destination(source.Width(), source.Height(), source.Channels());
+        ConvertDepth(source, destination, conversion);
+        return destination;
+    }
+}
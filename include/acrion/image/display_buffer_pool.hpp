@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        struct DisplayBufferPoolState
+        {
+            struct Block
+            {
+                std::unique_ptr<uint8_t[]> data;
+                size_t                     capacity{0};
+            };
+
+            std::mutex         mtx;
+            std::vector<Block> idle;
+            size_t             maxIdleBuffers;
+
+            explicit DisplayBufferPoolState(const size_t maxIdle)
+                : maxIdleBuffers(maxIdle)
+            {
+            }
+        };
+    }
+
+    /// An 8 bit display image drawn from a DisplayBufferPool. Its memory goes back to the pool when the handle is
+    /// destroyed, or is freed if the pool no longer exists.
+    class DisplayBuffer
+    {
+    public:
+        DisplayBuffer() = default;
+
+        DisplayBuffer(DisplayBuffer&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        DisplayBuffer& operator=(DisplayBuffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Release();
+                _block    = std::move(other._block);
+                _stride   = other._stride;
+                _width    = other._width;
+                _height   = other._height;
+                _channels = other._channels;
+                _pool     = std::move(other._pool);
+            }
+            return *this;
+        }
+
+        DisplayBuffer(const DisplayBuffer&)            = delete;
+        DisplayBuffer& operator=(const DisplayBuffer&) = delete;
+
+        ~DisplayBuffer()
+        {
+            Release();
+        }
+
+        uint8_t*       Data() { return _block.data.get(); }
+        const uint8_t* Data() const { return _block.data.get(); }
+        size_t         Stride() const { return _stride; }
+        int            Width() const { return _width; }
+        int            Height() const { return _height; }
+        int            Channels() const { return _channels; } ///< bytes per pixel
+        size_t         Size() const { return _stride * _height; }
+
+        explicit operator bool() const { return _block.data != nullptr; }
+
+    private:
+        friend class DisplayBufferPool;
+
+        void Release()
+        {
+            if (!_block.data)
+            {
+                return;
+            }
+
+            if (auto pool = _pool.lock())
+            {
+                std::lock_guard<std::mutex> lock(pool->mtx);
+                if (pool->idle.size() < pool->maxIdleBuffers)
+                {
+                    pool->idle.push_back(std::move(_block));
+                }
+            }
+
+            _block.data.reset();
+            _block.capacity = 0;
+        }
+
+        detail::DisplayBufferPoolState::Block         _block;
+        size_t                                        _stride{0};
+        int                                           _width{0};
+        int                                           _height{0};
+        int                                           _channels{0};
+        std::weak_ptr<detail::DisplayBufferPoolState> _pool;
+    };
+
+    /// Recycles the memory of display images, so that rendering a stream of frames (see
+    /// BitmapData::ConvertToDepth8) does not allocate once the pool is warm. Thread-safe.
+    class DisplayBufferPool
+    {
+    public:
+        /// `maxIdleBuffers` limits how many released buffers are kept for reuse
+        explicit DisplayBufferPool(const size_t maxIdleBuffers = 8)
+            : _state(std::make_shared<detail::DisplayBufferPoolState>(maxIdleBuffers))
+        {
+        }
+
+        /// Returns a buffer for `height` rows of `stride` bytes, reusing the smallest idle buffer that is large enough.
+        /// The content is undefined.
+        DisplayBuffer Acquire(const int width, const int height, const int channels, const size_t stride)
+        {
+            const size_t size = stride * height;
+
+            DisplayBuffer buffer;
+            buffer._stride   = stride;
+            buffer._width    = width;
+            buffer._height   = height;
+            buffer._channels = channels;
+            buffer._pool     = _state;
+
+            {
+                std::lock_guard<std::mutex> lock(_state->mtx);
+
+                auto& idle = _state->idle;
+                auto  best = idle.end();
+                for (auto it = idle.begin(); it != idle.end(); ++it)
+                {
+                    if (it->capacity >= size && (best == idle.end() || it->capacity < best->capacity))
+                    {
+                        best = it;
+                    }
+                }
+
+                if (best != idle.end())
+                {
+                    buffer._block = std::move(*best);
+                    idle.erase(best);
+                    return buffer;
+                }
+            }
+
+            buffer._block.data.reset(new uint8_t[size > 0 ? size : 1]);
+            buffer._block.capacity = size;
+            return buffer;
+        }
+
+        /// number of released buffers currently waiting for reuse
+        size_t IdleBuffers() const
+        {
+            std::lock_guard<std::mutex> lock(_state->mtx);
+            return _state->idle.size();
+        }
+
+    private:
+        std::shared_ptr<detail::DisplayBufferPoolState> _state;
+    };
+}
@@ -0,0 +1,255 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "change_tracker.hpp"
+#include "display_buffer_pool.hpp"
+#include "display_transform.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        /// Averages 2 x 2 blocks of `source` into the region [x0, x1) x [y0, y1) of `destination`, which has half the
+        /// size (rounded up). Blocks at odd right or bottom borders average the pixels that exist.
+        template <typename T>
+        void ReduceHalf(const BitmapData<T>& source, BitmapData<T>& destination, const int x0, const int y0, const int x1, const int y1)
+        {
+            const int channels = source.Channels();
+
+#pragma omp parallel for
+            for (int j = y0; j < y1; ++j)
+            {
+                const int sy0 = 2 * j;
+                const int sy1 = std::min(sy0 + 1, source.Height() - 1);
+                const T*  top = source.Buffer() + (size_t)sy0 * source.Width() * channels;
+                const T*  bot = source.Buffer() + (size_t)sy1 * source.Width() * channels;
+                T*        out = destination.Buffer() + (size_t)j * destination.Width() * channels;
+
+                for (int i = x0; i < x1; ++i)
+                {
+                    const int sx0 = 2 * i * channels;
+                    const int sx1 = std::min(2 * i + 1, source.Width() - 1) * channels;
+
+                    for (int c = 0; c < channels; ++c)
+                    {
+                        const double sum      = (double)top[sx0 + c] + (double)top[sx1 + c] + (double)bot[sx0 + c] + (double)bot[sx1 + c];
+                        out[i * channels + c] = ToSample<T>(sum * 0.25);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Keeps a pyramid of 2x area-averaged reductions of an image for zoomable display. A scaled ConvertToDepth8
+    /// starts from the smallest level that still has at least the requested resolution, instead of walking the full
+    /// image. Changes to the image are picked up through its ChangeTracker: only the affected regions of the levels
+    /// are rebuilt. The image must outlive the pyramid.
+    template <typename T>
+    class DisplayPyramid
+    {
+    public:
+        /// Reduces until both sides of the smallest level are at most `minSize` pixels.
+        explicit DisplayPyramid(const BitmapData<T>& image, const int minSize = 64)
+            : _image(image)
+            , _minSize(std::max(1, minSize))
+        {
+            Rebuild();
+        }
+
+        /// number of reduced levels; level 0 is the image itself
+        int Levels() const
+        {
+            std::shared_lock<std::shared_mutex> lock(_mtx);
+            return (int)_levels.size();
+        }
+
+        /// Returns the given level (0 = image, 1 = half size, ...), after bringing the pyramid up to date.
+        const BitmapData<T>& Level(const int level)
+        {
+            std::lock_guard<std::shared_mutex> lock(_mtx);
+            UpdateLocked();
+            return level == 0 ? _image : _levels.at(level - 1);
+        }
+
+        /// Rebuilds the parts of the levels whose source pixels changed since the last update.
+        void Update()
+        {
+            std::lock_guard<std::shared_mutex> lock(_mtx);
+            UpdateLocked();
+        }
+
+        /// Same as BitmapData::ConvertToDepth8, but reads from the nearest pyramid level. The displayed brightness range
+        /// of the image applies. Conversions from several threads run concurrently; only the update of the levels
+        /// before each of them is exclusive.
+        uint8_t* ConvertToDepth8(const DisplayOptions& options = {}, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0)
+        {
+            const auto transform = DisplayTransform<T>::Cached(options, _image.GetMinDisplayedBrightness(), _image.GetMaxDisplayedBrightness());
+
+            const auto lock  = LockUpdated();
+            const int  level = SelectLevel(x, y, w, h, scaledWidth, scaledHeight);
+            return (level == 0 ? _image : _levels[level - 1]).ConvertToDepth8(*transform, x, y, w, h, scaledWidth, scaledHeight);
+        }
+
+        void ConvertToDepth8(uint8_t* destination, const size_t destStride, const DisplayOptions& options, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0)
+        {
+            const auto transform = DisplayTransform<T>::Cached(options, _image.GetMinDisplayedBrightness(), _image.GetMaxDisplayedBrightness());
+
+            const auto lock  = LockUpdated();
+            const int  level = SelectLevel(x, y, w, h, scaledWidth, scaledHeight);
+            (level == 0 ? _image : _levels[level - 1]).ConvertToDepth8(destination, destStride, *transform, x, y, w, h, scaledWidth, scaledHeight);
+        }
+
+        DisplayBuffer ConvertToDepth8(DisplayBufferPool& pool, const DisplayOptions& options = {}, int x = 0, int y = 0, int w = 0, int h = 0, int scaledWidth = 0, int scaledHeight = 0)
+        {
+            const auto transform = DisplayTransform<T>::Cached(options, _image.GetMinDisplayedBrightness(), _image.GetMaxDisplayedBrightness());
+
+            if (w <= 0) w = _image.Width() - x;
+            if (h <= 0) h = _image.Height() - y;
+            if (scaledWidth <= 0) scaledWidth = w;
+            if (scaledHeight <= 0) scaledHeight = h;
+
+            DisplayBuffer buffer = pool.Acquire(scaledWidth, scaledHeight, transform->DestinationChannels(_image.Channels()), transform->Stride(_image.Channels(), scaledWidth));
+
+            const auto lock  = LockUpdated();
+            const int  level = SelectLevel(x, y, w, h, scaledWidth, scaledHeight);
+            (level == 0 ? _image : _levels[level - 1]).ConvertToDepth8(buffer.Data(), buffer.Stride(), *transform, x, y, w, h, scaledWidth, scaledHeight);
+            return buffer;
+        }
+
+    private:
+        void Rebuild()
+        {
+            _tracker = _image.TrackChanges();
+            _epoch   = _tracker->Epoch();
+            _levels.clear();
+
+            int count = 0;
+            for (int w = _image.Width(), h = _image.Height(); w > _minSize || h > _minSize; w = (w + 1) / 2, h = (h + 1) / 2)
+            {
+                ++count;
+            }
+
+            _levels.reserve(count); // keeps `source` valid and avoids deep copies of BitmapData on reallocation
+            for (int k = 0; k < count; ++k)
+            {
+                const BitmapData<T>& source = k == 0 ? _image : _levels[k - 1];
+                _levels.emplace_back((source.Width() + 1) / 2, (source.Height() + 1) / 2, source.Channels());
+                detail::ReduceHalf(source, _levels[k], 0, 0, _levels[k].Width(), _levels[k].Height());
+            }
+        }
+
+        /// Brings the levels up to date under the exclusive lock and returns a shared lock, which keeps them
+        /// unchanged while they are read. An update by another thread in between leaves them up to date as well.
+        std::shared_lock<std::shared_mutex> LockUpdated()
+        {
+            {
+                std::lock_guard<std::shared_mutex> lock(_mtx);
+                UpdateLocked();
+            }
+            return std::shared_lock<std::shared_mutex>(_mtx);
+        }
+
+        void UpdateLocked()
+        {
+            if (_image.Changes() != _tracker.get() || _image.Width() != _tracker->Width() || _image.Height() != _tracker->Height())
+            {
+                Rebuild(); // the image was reassigned
+                return;
+            }
+
+            // the snapshot is taken before the scan, so tiles stamped by marks still in progress are found again
+            const uint64_t epoch = _tracker->Epoch();
+            int            x, y, w, h;
+            if (!_tracker->ChangedBounds(_epoch, x, y, w, h))
+            {
+                return;
+            }
+            _epoch = epoch;
+
+            int x1 = x + w;
+            int y1 = y + h;
+            for (size_t k = 0; k < _levels.size(); ++k)
+            {
+                x  = x / 2;
+                y  = y / 2;
+                x1 = std::min(_levels[k].Width(), (x1 + 1) / 2);
+                y1 = std::min(_levels[k].Height(), (y1 + 1) / 2);
+                detail::ReduceHalf(k == 0 ? _image : _levels[k - 1], _levels[k], x, y, x1, y1);
+            }
+        }
+
+        /// Picks the smallest level whose resolution is at least that of the output and rescales the region to it.
+        int SelectLevel(int& x, int& y, int& w, int& h, int& scaledWidth, int& scaledHeight) const
+        {
+            if (w <= 0) w = _image.Width() - x;
+            if (h <= 0) h = _image.Height() - y;
+            if (scaledWidth <= 0) scaledWidth = w;
+            if (scaledHeight <= 0) scaledHeight = h;
+
+            // the size that ConvertToDepth8 fills after preserving the aspect ratio
+            const double aspectRatio = static_cast<double>(w) / h;
+            const bool   wider       = static_cast<double>(scaledWidth) / scaledHeight > aspectRatio;
+            const double fillWidth   = wider ? scaledHeight * aspectRatio : scaledWidth;
+
+            int level = 0;
+            while (level < (int)_levels.size() && fillWidth * (2 << level) <= w)
+            {
+                ++level;
+            }
+
+            if (level > 0)
+            {
+                const double factor = std::ldexp(1.0, -level);
+                const int    x1     = (int)std::lround((x + w) * factor);
+                const int    y1     = (int)std::lround((y + h) * factor);
+                x                   = (int)std::lround(x * factor);
+                y                   = (int)std::lround(y * factor);
+                w                   = std::max(1, x1 - x);
+                h                   = std::max(1, y1 - y);
+            }
+
+            return level;
+        }
+
+        const BitmapData<T>&                 _image;
+        const int                            _minSize;
+        std::shared_ptr<const ChangeTracker> _tracker;
+        uint64_t                             _epoch{0};
+        std::vector<BitmapData<T>>           _levels;
+        mutable std::shared_mutex            _mtx;
+    };
+}
@@ -0,0 +1,440 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "colormap.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    /// byte order of the pixels written by ConvertToDepth8
+    enum class DisplayLayout
+    {
+        Automatic,  // Bgra for RGB and ARGB images and for gray images with a colormap, Gray8 for other gray images
+        Bgra,       // 4 bytes per pixel; gray images are replicated into B, G and R
+        Gray8,      // 1 byte per pixel; colour images are reduced to their luma
+        Rgba,       // 4 bytes per pixel
+        Argb,       // 4 bytes per pixel
+        Rgb,        // 3 bytes per pixel, no alpha
+        GrayAsBgra, // 4 bytes per pixel; the luma is replicated into B, G and R
+    };
+
+    /// Display settings that do not depend on the sample type. Together with the displayed brightness range of an
+    /// image they define a DisplayTransform. Gamma, layout and colormap define its tables and the rendered values;
+    /// scaling, dither and rowAlignment only affect how a single call renders with it.
+    struct DisplayOptions
+    {
+        double                          gamma{0};
+        DisplayLayout                   layout{DisplayLayout::Automatic};
+        ResampleFilter                  scaling{ResampleFilter::Nearest}; // used when the output size differs from the region size
+        bool                            dither{false};                    // ordered 8 x 8 Bayer dither instead of rounding to 8 bit
+        int                             rowAlignment{0};                  // row stride multiple in bytes; 0: 4 for Gray8 and Rgb, none otherwise
+        std::shared_ptr<const Colormap> colormap;                         // false colour for gray images; ignored for colour images
+
+        bool operator==(const DisplayOptions& other) const
+        {
+            return gamma == other.gamma && layout == other.layout && scaling == other.scaling && dither == other.dither && rowAlignment == other.rowAlignment
+                && (colormap == other.colormap || (colormap && other.colormap && *colormap == *other.colormap));
+        }
+        bool operator!=(const DisplayOptions& other) const { return !operator==(other); }
+
+        /// whether both options render the same display values, i.e. equal apart from scaling, dither and rowAlignment
+        bool SameTable(const DisplayOptions& other) const
+        {
+            return gamma == other.gamma && layout == other.layout
+                && (colormap == other.colormap || (colormap && other.colormap && *colormap == *other.colormap));
+        }
+    };
+
+    namespace detail
+    {
+        /// Branch-free log2 for the display mapping of types without a table. The exponent is read from the bit
+        /// pattern and the mantissa m, reduced to [sqrt(1/2), sqrt(2)), enters ln m = 2 atanh(s) = 2 (s + s^3/3 +
+        /// ... + s^9/9) with s = (m - 1) / (m + 1), |s| <= 0.1716. The truncated terms sum to less than 1.1e-9 in
+        /// log2 units. Like std::log2, returns -inf for 0 and NaN for negative values and NaN.
+        inline double FastLog2(const double x)
+        {
+            constexpr double two54 = 18014398509481984.0;
+
+            const bool   subnormal = x < std::numeric_limits<double>::min();
+            const double normal    = subnormal ? x * two54 : x;
+            uint64_t     bits;
+            std::memcpy(&bits, &normal, sizeof bits);
+
+            const int exponent = (int)((bits >> 52) & 0x7ff) - 1023 - (subnormal ? 54 : 0);
+            bits               = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+            double m;
+            std::memcpy(&m, &bits, sizeof m);
+
+            const bool   high   = m > 1.4142135623730951;
+            const double e      = exponent + (high ? 1.0 : 0.0);
+            m                   = high ? m * 0.5 : m;
+            const double s      = (m - 1) / (m + 1);
+            const double s2     = s * s;
+            const double series = s * (2.0 + s2 * (2.0 / 3 + s2 * (2.0 / 5 + s2 * (2.0 / 7 + s2 * (2.0 / 9)))));
+            const double result = e + series * 1.4426950408889634; // 1 / ln 2
+
+            constexpr double infinity = std::numeric_limits<double>::infinity();
+            return x > 0 ? (x == infinity ? infinity : result) : x == 0 ? -infinity : std::numeric_limits<double>::quiet_NaN();
+        }
+
+        /// Maps sample values to display values: window/level to [min, max], followed by a blend of linear and
+        /// logarithmic response controlled by gamma (linear if gamma == 0). The coefficients are computed once per
+        /// transform instead of once per sample.
+        template <typename T>
+        class DisplayMapping
+        {
+        public:
+            DisplayMapping(const double gamma, const T min, const T max)
+                : _gamma(gamma)
+                , _min(min)
+                , _max(max)
+                , _range(max > min ? (double)(T)(max - min) : 0.0)
+                , _gamma1(std::min(1.0, gamma * 2))
+                , _delta(9 - gamma * 6)
+                , _factor(256.0 / (double)(log1p((long double)max - min) / _log2 - _delta))
+            {
+            }
+
+            /// the display value in [0, 255] before rounding
+            double Continuous(T val) const
+            {
+                val = std::min(std::max(val, _min), _max);
+
+                const T      diff = val >= _min ? val - _min : 0;
+                const double val0 = _range > 0 ? 255.0 * diff / _range : 0.0;
+
+                if (_gamma == 0)
+                {
+                    return std::max(0.0, std::min(255.0, val0));
+                }
+
+                const double result = log((double)val) / _log2 - _delta; // cppcheck-suppress invalidFunctionArg
+                const double val1   = (result <= 0) ? 0 : result * _factor;
+                const double t      = _gamma1 * val1 + (1 - _gamma1) * val0;
+
+                return std::max(0.0, std::min(255.0, t));
+            }
+
+            /// the display value in 8.8 fixed point, for dithering
+            uint16_t Fixed(const T val) const
+            {
+                return (uint16_t)std::lround(Continuous(val) * 256.0);
+            }
+
+            uint8_t operator()(const T val) const
+            {
+                return (uint8_t)std::lround(Continuous(val));
+            }
+
+            /// form used by the row converters, which pass the output position for dithering
+            uint8_t operator()(const T val, int, int) const
+            {
+                return operator()(val);
+            }
+
+            /// Maps `n` consecutive samples like operator(), but with FastLog2 and without branches, so that the loop
+            /// vectorises. Results differ from operator() by at most one level, for display values next to a rounding
+            /// boundary.
+            void MapRow(const T* src, const size_t n, uint8_t* out) const
+            {
+                if (_gamma == 0)
+                {
+#pragma omp simd
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        const T      val  = std::min(std::max(src[i], _min), _max);
+                        const T      diff = val >= _min ? val - _min : 0;
+                        const double val0 = _range > 0 ? 255.0 * diff / _range : 0.0;
+                        out[i]            = (uint8_t)(int)(std::max(0.0, std::min(255.0, val0)) + 0.5);
+                    }
+                }
+                else
+                {
+#pragma omp simd
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        const T      val    = std::min(std::max(src[i], _min), _max);
+                        const T      diff   = val >= _min ? val - _min : 0;
+                        const double val0   = _range > 0 ? 255.0 * diff / _range : 0.0;
+                        const double result = FastLog2((double)val) - _delta;
+                        const double val1   = (result <= 0) ? 0 : result * _factor;
+                        const double t      = _gamma1 * val1 + (1 - _gamma1) * val0;
+                        out[i]              = (uint8_t)(int)(std::max(0.0, std::min(255.0, t)) + 0.5);
+                    }
+                }
+            }
+
+        private:
+            const double _log2{std::log(2.0)};
+            double       _gamma;
+            T            _min;
+            T            _max;
+            double       _range;
+            double       _gamma1;
+            double       _delta;
+            double       _factor;
+        };
+
+        /// 8 x 8 Bayer matrix, the threshold map of ordered dithering
+        constexpr uint8_t bayer8[8][8] = {
+            {0, 32, 8, 40, 2, 34, 10, 42},
+            {48, 16, 56, 24, 50, 18, 58, 26},
+            {12, 44, 4, 36, 14, 46, 6, 38},
+            {60, 28, 52, 20, 62, 30, 54, 22},
+            {3, 35, 11, 43, 1, 33, 9, 41},
+            {51, 19, 59, 27, 49, 17, 57, 25},
+            {15, 47, 7, 39, 13, 45, 5, 37},
+            {63, 31, 55, 23, 61, 29, 53, 21}};
+
+        /// bytes per pixel of a layout other than Automatic
+        constexpr int LayoutChannels(const DisplayLayout layout)
+        {
+            return layout == DisplayLayout::Gray8 ? 1 : layout == DisplayLayout::Rgb ? 3 : 4;
+        }
+
+        /// the dither threshold at output position (x, y) in units of 1/256, centred in its interval
+        inline int DitherThreshold(const int x, const int y)
+        {
+            return bayer8[y & 7][x & 7] * 4 + 2;
+        }
+
+        /// Wraps the map of a gray image that is rendered in false colour: `index` yields the display value as
+        /// usual, which the row converters then look up in `colormap` in the same pass.
+        template <typename Index>
+        struct PaletteMap
+        {
+            Index           index;
+            const Colormap* colormap;
+
+            template <typename T>
+            uint8_t operator()(const T val, const int x, const int y) const
+            {
+                return index(val, x, y);
+            }
+        };
+
+        /// map of samples that are display values already
+        struct IdentityMap
+        {
+            uint8_t operator()(const uint8_t val, int, int) const { return val; }
+        };
+
+        /// whether a map can convert whole rows at once, see DisplayMapping::MapRow
+        template <typename Map, typename = void>
+        struct HasMapRow : std::false_type
+        {
+        };
+
+        template <typename Map>
+        struct HasMapRow<Map, std::void_t<decltype(&Map::MapRow)>> : std::true_type
+        {
+        };
+
+        template <typename Map>
+        struct IsPaletteMap : std::false_type
+        {
+        };
+
+        template <typename Index>
+        struct IsPaletteMap<PaletteMap<Index>> : std::true_type
+        {
+        };
+    }
+
+    /// Immutable description of how samples of type T are rendered for display: the DisplayOptions and the
+    /// displayed brightness range. For 8 and 16 bit samples it holds a table with the display value of every
+    /// possible sample value, both rounded and in fixed point for dithering. The tables are shared between all
+    /// transforms obtained from Cached() for the same gamma, layout, colormap and range, whatever their scaling,
+    /// dither and row alignment, and rendering with them needs no locking.
+    template <typename T>
+    class DisplayTransform
+    {
+    public:
+        DisplayTransform(const DisplayOptions& options, const T min, const T max)
+            : _options(options)
+            , _tables(std::make_shared<const Tables>(options.gamma, min, max))
+        {
+        }
+
+        /// a transform with the tables of `other` and the scaling, dither and row alignment of `options`
+        DisplayTransform(const DisplayTransform& other, const DisplayOptions& options)
+            : _options(options)
+            , _tables(other._tables)
+        {
+            _options.gamma    = other._options.gamma;
+            _options.layout   = other._options.layout;
+            _options.colormap = other._options.colormap;
+        }
+
+        /// Returns a transform for the given settings from a small process-wide cache, creating it if necessary.
+        /// The cache is keyed on the settings that define the tables (see DisplayOptions::SameTable), so changing
+        /// only the scaling, dither or row alignment reuses them. The lock is held only to look up or insert, never
+        /// while a table is built.
+        static std::shared_ptr<const DisplayTransform> Cached(const DisplayOptions& options, const T min, const T max)
+        {
+            static std::mutex                                         mtx;
+            static std::list<std::shared_ptr<const DisplayTransform>> cache; // most recently used first
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                for (auto it = cache.begin(); it != cache.end(); ++it)
+                {
+                    if ((*it)->Matches(options, min, max))
+                    {
+                        cache.splice(cache.begin(), cache, it);
+                        const std::shared_ptr<const DisplayTransform>& found = cache.front();
+                        return found->Options() == options ? found : std::make_shared<const DisplayTransform>(*found, options);
+                    }
+                }
+            }
+
+            auto transform = std::make_shared<const DisplayTransform>(options, min, max);
+
+            std::lock_guard<std::mutex> lock(mtx);
+            cache.push_front(transform);
+            if (cache.size() > cacheCapacity)
+            {
+                cache.pop_back();
+            }
+
+            return transform;
+        }
+
+        static constexpr bool HasTable() { return sizeof(T) <= 2 && std::numeric_limits<T>::is_integer; }
+
+        const DisplayOptions& Options() const { return _options; }
+        T                     Min() const { return _tables->min; }
+        T                     Max() const { return _tables->max; }
+
+        /// the display value of every sample value for 8 and 16 bit samples, nullptr otherwise
+        const uint8_t* Table() const { return _tables->table.empty() ? nullptr : _tables->table.data(); }
+
+        /// like Table(), but in 8.8 fixed point, for dithering
+        const uint16_t* FixedTable() const { return _tables->fixedTable.empty() ? nullptr : _tables->fixedTable.data(); }
+
+        const detail::DisplayMapping<T>& Mapping() const { return _tables->mapping; }
+
+        uint8_t operator()(const T val) const
+        {
+            if constexpr (HasTable())
+            {
+                return _tables->table[val];
+            }
+            else
+            {
+                return _tables->mapping(val);
+            }
+        }
+
+        /// whether this transform renders the same display values as one for `options`, `min` and `max`; scaling,
+        /// dither and row alignment are not compared
+        bool Matches(const DisplayOptions& options, const T min, const T max) const
+        {
+            return _options.SameTable(options) && _tables->min == min && _tables->max == max;
+        }
+
+        /// the layout used when rendering an image with `sourceChannels` channels, with Automatic resolved
+        DisplayLayout Layout(const int sourceChannels) const
+        {
+            if (sourceChannels == 1 && _options.colormap)
+            {
+                // false colour needs colour output
+                const DisplayLayout layout = _options.layout;
+                return layout == DisplayLayout::Automatic || layout == DisplayLayout::Gray8 || layout == DisplayLayout::GrayAsBgra ? DisplayLayout::Bgra : layout;
+            }
+            if (_options.layout == DisplayLayout::Automatic)
+            {
+                return sourceChannels >= 3 ? DisplayLayout::Bgra : DisplayLayout::Gray8;
+            }
+            return _options.layout;
+        }
+
+        /// number of bytes per destination pixel when rendering an image with `sourceChannels` channels
+        int DestinationChannels(const int sourceChannels) const
+        {
+            return detail::LayoutChannels(Layout(sourceChannels));
+        }
+
+        /// number of bytes per destination row, including the padding required by the row alignment
+        size_t Stride(const int sourceChannels, const int width) const
+        {
+            const size_t destChannels = DestinationChannels(sourceChannels);
+            const size_t align        = _options.rowAlignment > 0 ? (size_t)_options.rowAlignment : destChannels == 4 ? 1 : 4;
+            return ((size_t)width * destChannels + align - 1) / align * align;
+        }
+
+    private:
+        static constexpr size_t cacheCapacity{16};
+
+        /// the part shared by all transforms with the same gamma and range
+        struct Tables
+        {
+            Tables(const double gamma, const T min, const T max)
+                : min(min)
+                , max(max)
+                , mapping(gamma, min, max)
+            {
+                if constexpr (HasTable())
+                {
+                    const int size = (int)std::numeric_limits<T>::max() + 1;
+
+                    table.resize(size);
+                    fixedTable.resize(size);
+
+#pragma omp parallel for
+                    for (int v = 0; v < size; ++v)
+                    {
+                        const double value = mapping.Continuous((T)v);
+                        table[v]           = (uint8_t)std::lround(value);
+                        fixedTable[v]      = (uint16_t)std::lround(value * 256.0);
+                    }
+                }
+            }
+
+            T                         min;
+            T                         max;
+            detail::DisplayMapping<T> mapping;
+            std::vector<uint8_t>      table;
+            std::vector<uint16_t>     fixedTable;
+        };
+
+        DisplayOptions                _options;
+        std::shared_ptr<const Tables> _tables;
+    };
+}
@@ -0,0 +1,208 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "channel_conversion.hpp"
+#include "depth_conversion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        // Color::WithBrightness keeps U and V and replaces Y. Substituting U and V into the inverse transform gives
+        // rgb' = Y' + M * rgb, with one matrix row per output channel.
+        constexpr double withBrightnessMatrix[3][3] = {
+            {1.13983 * 0.615, 1.13983 * -0.51498, 1.13983 * -0.10001},
+            {-0.39465 * -0.14713 - 0.58060 * 0.615, -0.39465 * -0.28886 - 0.58060 * -0.51498, -0.39465 * 0.436 - 0.58060 * -0.10001},
+            {2.03211 * -0.14713, 2.03211 * -0.28886, 2.03211 * 0.436}};
+
+        constexpr int32_t ToFixed16(const double v)
+        {
+            return (int32_t)(v * 65536.0 + (v >= 0 ? 0.5 : -0.5));
+        }
+
+        // Rows of the matrix above in 16 bit fixed point. The published YUV constants leave a residual of about 1e-5
+        // per row; the green column absorbs it, so that gray pixels map exactly to Y' like in Color::WithBrightness.
+        inline std::array<std::array<int32_t, 3>, 3> WithBrightnessMatrixFixed16()
+        {
+            std::array<std::array<int32_t, 3>, 3> m{};
+            for (int row = 0; row < 3; ++row)
+            {
+                m[row][0] = ToFixed16(withBrightnessMatrix[row][0]);
+                m[row][2] = ToFixed16(withBrightnessMatrix[row][2]);
+                m[row][1] = -(m[row][0] + m[row][2]);
+            }
+            return m;
+        }
+
+        inline void ClipRegion(const int width, const int height, int& x, int& y, int& w, int& h)
+        {
+            if (w <= 0) w = width - x;
+            if (h <= 0) h = height - y;
+
+            const int x1 = std::min(width, x + w);
+            const int y1 = std::min(height, y + h);
+            x            = std::max(0, x);
+            y            = std::max(0, y);
+            w            = std::max(0, x1 - x);
+            h            = std::max(0, y1 - y);
+        }
+    }
+
+    /// Replaces the luma of every pixel in the region (x, y, w, h) by `lut[luma]` while preserving chroma, like
+    /// Color::WithBrightness does for a single colour. `lut` needs one entry per possible sample value; w or h <= 0
+    /// extend the region to the image border. Alpha is left untouched.
+    template <typename T>
+    void RemapLuminance(BitmapData<T>& image, const std::vector<T>& lut, int x = 0, int y = 0, int w = 0, int h = 0)
+    {
+        static_assert(sizeof(T) <= 2 && std::numeric_limits<T>::is_integer, "acrion::image::RemapLuminance: lookup tables require 8 or 16 bit samples");
+
+        if (lut.size() != (size_t)std::numeric_limits<T>::max() + 1)
+        {
+            throw std::runtime_error("acrion::image::RemapLuminance: lookup table must have " + std::to_string((size_t)std::numeric_limits<T>::max() + 1) + " entries");
+        }
+
+        detail::ClipRegion(image.Width(), image.Height(), x, y, w, h);
+
+        const int channels = image.Channels();
+        const T*  table    = lut.data();
+
+        if (channels == 1)
+        {
+#pragma omp parallel for
+            for (int j = y; j < y + h; ++j)
+            {
+                T* row = image.Buffer() + ((size_t)j * image.Width() + x);
+
+                for (int i = 0; i < w; ++i)
+                {
+                    row[i] = table[row[i]];
+                }
+            }
+
+            image.Invalidate(x, y, w, h);
+            return;
+        }
+
+        using Acc                 = std::conditional_t<sizeof(T) == 1, int32_t, int64_t>;
+        const auto   m            = detail::WithBrightnessMatrixFixed16();
+        const Acc    max          = std::numeric_limits<T>::max();
+        const size_t bufferOffset = (size_t)x * channels + (channels == 4 ? 1 : 0);
+
+#pragma omp parallel for
+        for (int j = y; j < y + h; ++j)
+        {
+            T* rgb = image.Buffer() + (size_t)j * image.Width() * channels + bufferOffset;
+
+#pragma omp simd
+            for (int i = 0; i < w; ++i)
+            {
+                T* p = rgb + (size_t)i * channels;
+
+                const Acc r = p[0];
+                const Acc g = p[1];
+                const Acc b = p[2];
+
+                const Acc luma = (Acc)table[(detail::grayWeightRed * r + detail::grayWeightGreen * g + detail::grayWeightBlue * b + 32768) >> 16];
+
+                p[0] = (T)std::min(max, std::max((Acc)0, luma + ((m[0][0] * r + m[0][1] * g + m[0][2] * b + 32768) >> 16)));
+                p[1] = (T)std::min(max, std::max((Acc)0, luma + ((m[1][0] * r + m[1][1] * g + m[1][2] * b + 32768) >> 16)));
+                p[2] = (T)std::min(max, std::max((Acc)0, luma + ((m[2][0] * r + m[2][1] * g + m[2][2] * b + 32768) >> 16)));
+            }
+        }
+
+        image.Invalidate(x, y, w, h);
+    }
+
+    /// Applies the luminance curve `T curve(T luma)` to the region (x, y, w, h) while preserving chroma. For 8 and
+    /// 16 bit images the curve is sampled into a lookup table once; other depths evaluate it per pixel in double precision.
+    template <typename T, typename Curve>
+    void RemapLuminance(BitmapData<T>& image, Curve curve, int x = 0, int y = 0, int w = 0, int h = 0)
+    {
+        if constexpr (sizeof(T) <= 2 && std::numeric_limits<T>::is_integer)
+        {
+            std::vector<T> lut((size_t)std::numeric_limits<T>::max() + 1);
+            for (size_t v = 0; v < lut.size(); ++v)
+            {
+                lut[v] = (T)curve((T)v);
+            }
+
+            RemapLuminance(image, lut, x, y, w, h);
+        }
+        else
+        {
+            detail::ClipRegion(image.Width(), image.Height(), x, y, w, h);
+
+            const int    channels = image.Channels();
+            const double max      = std::is_floating_point_v<T> ? std::numeric_limits<double>::max() : detail::MaxConvertible<T>();
+            const auto&  m        = detail::withBrightnessMatrix;
+
+#pragma omp parallel for
+            for (int j = y; j < y + h; ++j)
+            {
+                T* p = image.Buffer() + ((size_t)j * image.Width() + x) * channels + (channels == 4 ? 1 : 0);
+
+                for (int i = 0; i < w; ++i, p += channels)
+                {
+                    if (channels == 1)
+                    {
+                        p[0] = (T)curve(p[0]);
+                        continue;
+                    }
+
+                    const double r    = (double)p[0];
+                    const double g    = (double)p[1];
+                    const double b    = (double)p[2];
+                    const double luma = (double)curve(Color<T>(p[0], p[1], p[2]).Gray());
+
+                    if (p[0] == p[1] && p[0] == p[2])
+                    {
+                        p[0] = p[1] = p[2] = (T)luma;
+                        continue;
+                    }
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        const double v = std::min(max, std::max(0.0, luma + m[k][0] * r + m[k][1] * g + m[k][2] * b));
+                        p[k]           = std::is_floating_point_v<T> ? (T)v : (T)std::floor(v + 0.5);
+                    }
+                }
+            }
+
+            image.Invalidate(x, y, w, h);
+        }
+    }
+}
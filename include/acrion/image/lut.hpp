@@ -0,0 +1,170 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        template <typename T>
+        constexpr size_t LutSize()
+        {
+            static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>, "acrion::image::ApplyLut: lookup tables require 8 or 16 bit samples");
+            return (size_t)std::numeric_limits<T>::max() + 1;
+        }
+
+        template <typename T, typename U>
+        void CheckLutGeometry(const BitmapData<T>& source, const BitmapData<U>& destination, const std::vector<U>& lut)
+        {
+            if (source.Width() != destination.Width() || source.Height() != destination.Height() || source.Channels() != destination.Channels())
+            {
+                throw std::runtime_error("acrion::image::ApplyLut: destination image has different geometry");
+            }
+
+            if (lut.size() != LutSize<T>())
+            {
+                throw std::runtime_error("acrion::image::ApplyLut: lookup table has " + std::to_string(lut.size()) + " instead of " + std::to_string(LutSize<T>()) + " entries");
+            }
+        }
+    }
+
+    /// Replaces every sample `v` of `source` by `lut[v]` and stores it in `destination`, which must have the same
+    /// geometry but may have any element type. `source` and `destination` may be the same image.
+    /// `lut` must have 256 (8 bit source) or 65536 (16 bit source) entries.
+    template <typename T, typename U>
+    void ApplyLut(const BitmapData<T>& source, BitmapData<U>& destination, const std::vector<U>& lut)
+    {
+        detail::CheckLutGeometry(source, destination, lut);
+
+        const int n     = source.Width() * source.Channels();
+        const U*  table = lut.data();
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            const T* src  = source.Buffer() + (size_t)y * n;
+            U*       dest = destination.Buffer() + (size_t)y * n;
+
+#pragma omp simd
+            for (int i = 0; i < n; ++i)
+            {
+                dest[i] = table[src[i]];
+            }
+        }
+
+        destination.Invalidate();
+    }
+
+    /// Like above, but with one lookup table per channel, in channel index order (e.g. alpha, red, green, blue).
+    template <typename T, typename U>
+    void ApplyLut(const BitmapData<T>& source, BitmapData<U>& destination, const std::vector<std::vector<U>>& luts)
+    {
+        const int channels = source.Channels();
+
+        if ((int)luts.size() != channels)
+        {
+            throw std::runtime_error("acrion::image::ApplyLut: expected " + std::to_string(channels) + " lookup tables, got " + std::to_string(luts.size()));
+        }
+
+        for (const auto& lut : luts)
+        {
+            detail::CheckLutGeometry(source, destination, lut);
+        }
+
+        if (channels == 1)
+        {
+            ApplyLut(source, destination, luts[0]);
+            return;
+        }
+
+        const int width = source.Width();
+        const U*  tables[4]{};
+        for (int k = 0; k < channels; ++k)
+        {
+            tables[k] = luts[k].data();
+        }
+
+#pragma omp parallel for
+        for (int y = 0; y < source.Height(); ++y)
+        {
+            const T* src  = source.Buffer() + (size_t)y * width * channels;
+            U*       dest = destination.Buffer() + (size_t)y * width * channels;
+
+            for (int k = 0; k < channels; ++k)
+            {
+                const U* table = tables[k];
+
+#pragma omp simd
+                for (int i = 0; i < width; ++i)
+                {
+                    dest[i * channels + k] = table[src[i * channels + k]];
+                }
+            }
+        }
+
+        destination.Invalidate();
+    }
+
+    template <typename T, typename U>
+    BitmapData<U> ApplyLut(const BitmapData<T>& source, const std::vector<U>& lut)
+    {
+        BitmapData<U> destination(source.Width(), source.Height(), source.Channels());
+        ApplyLut(source, destination, lut);
+        return destination;
+    }
+
+    template <typename T, typename U>
+    BitmapData<U> ApplyLut(const BitmapData<T>& source, const std::vector<std::vector<U>>& luts)
+    {
+        BitmapData<U> destination(source.Width(), source.Height(), source.Channels());
+        ApplyLut(source, destination, luts);
+        return destination;
+    }
+
+    /// Samples `U f(T v)` into a lookup table for ApplyLut.
+    template <typename T, typename U, typename Function>
+    std::vector<U> MakeLut(Function f)
+    {
+        std::vector<U> lut(detail::LutSize<T>());
+
+#pragma omp parallel for
+        for (int v = 0; v < (int)lut.size(); ++v)
+        {
+            lut[v] = (U)f((T)v);
+        }
+
+        return lut;
+    }
+}
@@ -25,8 +25,14 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <functional>
+#include <tuple>
+#include <vector>
 
 namespace acrion::image
 {
@@ -39,14 +45,35 @@ namespace acrion::image
         operator T() const { return _val; } // NOLINT(google-explicit-constructor)
 
         MixableScalar<T> Mix(const std::vector<std::tuple<double, MixableScalar<T>>>& mixableScalars) const
+        {
+            return MixRange(mixableScalars.begin(), mixableScalars.end());
+        }
+
+        /// same as above for a fixed number of values, without heap allocation
+        template <size_t N>
+        MixableScalar<T> Mix(const std::array<std::tuple<double, MixableScalar<T>>, N>& mixableScalars) const
+        {
+            return MixRange(mixableScalars.begin(), mixableScalars.end());
+        }
+
+        /// same as above with the pairs as arguments: a.Mix(0.25, b, 0.5, c)
+        template <typename... Rest>
+        MixableScalar<T> Mix(const double weight, const MixableScalar<T>& mixableScalar, const Rest&... rest) const
+        {
+            return Mix(utility::Weighted<MixableScalar<T>>(weight, mixableScalar, rest...));
+        }
+
+    private:
+        template <typename Iterator>
+        MixableScalar<T> MixRange(const Iterator begin, const Iterator end) const
         {
             double sum  = 0.0;
             double sumW = 0.0;
 
-            for (const auto& current : mixableScalars)
+            for (Iterator current = begin; current != end; ++current)
             {
-                const double         weight = std::get<0>(current);
-                const MixableScalar& v      = std::get<1>(current);
+                const double         weight = std::get<0>(*current);
+                const MixableScalar& v      = std::get<1>(*current);
                 sumW += weight;
                 sum += weight * (double)v;
             }
@@ -56,7 +83,6 @@ namespace acrion::image
             return MixableScalar<T>(static_cast<T>(std::llround((weight * _val + sum))));
         }
 
-    private:
         T _val;
     };
 }
@@ -0,0 +1,356 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace acrion::image
+{
+    enum class Rotation
+    {
+        Rotate90,  // clockwise
+        Rotate180,
+        Rotate270, // clockwise, i.e. 90 degrees counter-clockwise
+    };
+
+    enum class FlipDirection
+    {
+        Horizontal, // swaps left and right
+        Vertical,   // swaps top and bottom
+    };
+
+    namespace detail
+    {
+        /// Edge length of the square tiles of the transposing operations, in pixels. While a tile is written row by
+        /// row, the source pixels it reads (one per source row of the tile) stay in the L1 cache.
+        constexpr int orientationTileSize = 32;
+
+        /// calls `f` with the channel count of the image as std::integral_constant, so that pixel copies unroll
+        template <typename Function>
+        void WithChannels(const int channels, Function f)
+        {
+            switch (channels)
+            {
+            case 1:
+                f(std::integral_constant<int, 1>());
+                break;
+            case 3:
+                f(std::integral_constant<int, 3>());
+                break;
+            default:
+                f(std::integral_constant<int, 4>());
+                break;
+            }
+        }
+
+        template <int C, typename T>
+        inline void CopyPixel(const T* from, T* to)
+        {
+            for (int c = 0; c < C; ++c)
+            {
+                to[c] = from[c];
+            }
+        }
+
+        template <int C, typename T>
+        inline void SwapPixels(T* a, T* b)
+        {
+            for (int c = 0; c < C; ++c)
+            {
+                std::swap(a[c], b[c]);
+            }
+        }
+
+        /// Writes the transpose of `source` to `destination`, tile by tile. Destination row y reads source column y,
+        /// or column width - 1 - y with `mirrorColumns`; it walks that column upwards with `mirrorRows`. Rotations by
+        /// 90 and 270 degrees are transposes with one of the mirrors.
+        template <int C, typename T>
+        void TransposeTiles(const BitmapData<T>& source, BitmapData<T>& destination, const bool mirrorRows, const bool mirrorColumns)
+        {
+            const int       sourceWidth  = source.Width();
+            const int       sourceHeight = source.Height();
+            const int       width        = destination.Width();
+            const int       height       = destination.Height();
+            const int       tilesX       = (width + orientationTileSize - 1) / orientationTileSize;
+            const int       tilesY       = (height + orientationTileSize - 1) / orientationTileSize;
+            const ptrdiff_t step         = (ptrdiff_t)sourceWidth * C * (mirrorRows ? -1 : 1);
+
+#pragma omp parallel for schedule(static)
+            for (int tile = 0; tile < tilesX * tilesY; ++tile)
+            {
+                const int x0 = (tile % tilesX) * orientationTileSize;
+                const int y0 = (tile / tilesX) * orientationTileSize;
+                const int x1 = std::min(width, x0 + orientationTileSize);
+                const int y1 = std::min(height, y0 + orientationTileSize);
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    const int sx  = mirrorColumns ? sourceWidth - 1 - y : y;
+                    const int sy  = mirrorRows ? sourceHeight - 1 - x0 : x0;
+                    const T*  p   = source.Buffer() + ((size_t)sy * sourceWidth + sx) * C;
+                    T*        out = destination.Buffer() + ((size_t)y * width + x0) * C;
+
+                    for (int x = x0; x < x1; ++x, p += step, out += C)
+                    {
+                        CopyPixel<C>(p, out);
+                    }
+                }
+            }
+        }
+
+        /// Transposes a square image in place by swapping each tile above the diagonal with its mirror below.
+        template <int C, typename T>
+        void TransposeTilesInPlace(BitmapData<T>& image)
+        {
+            const int size  = image.Width();
+            const int tiles = (size + orientationTileSize - 1) / orientationTileSize;
+            T*        data  = image.Buffer();
+
+#pragma omp parallel for schedule(dynamic)
+            for (int ty = 0; ty < tiles; ++ty)
+            {
+                for (int tx = ty; tx < tiles; ++tx)
+                {
+                    const int x0 = tx * orientationTileSize;
+                    const int y0 = ty * orientationTileSize;
+                    const int x1 = std::min(size, x0 + orientationTileSize);
+                    const int y1 = std::min(size, y0 + orientationTileSize);
+
+                    for (int y = y0; y < y1; ++y)
+                    {
+                        for (int x = std::max(x0, y + 1); x < x1; ++x)
+                        {
+                            SwapPixels<C>(data + ((size_t)y * size + x) * C, data + ((size_t)x * size + y) * C);
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Copies the rows of `source` to `destination`, bottom to top with `mirrorRows`, and each row right to left
+        /// with `mirrorPixels`. Both mirrors together rotate by 180 degrees.
+        template <int C, typename T>
+        void MirrorRows(const BitmapData<T>& source, BitmapData<T>& destination, const bool mirrorRows, const bool mirrorPixels)
+        {
+            const int width  = source.Width();
+            const int height = source.Height();
+
+#pragma omp parallel for
+            for (int y = 0; y < height; ++y)
+            {
+                const T* in  = source.Buffer() + (size_t)(mirrorRows ? height - 1 - y : y) * width * C;
+                T*       out = destination.Buffer() + (size_t)y * width * C;
+
+                if (!mirrorPixels)
+                {
+                    std::copy(in, in + (size_t)width * C, out);
+                    continue;
+                }
+
+                const T* p = in + (size_t)(width - 1) * C;
+                for (int x = 0; x < width; ++x, p -= C, out += C)
+                {
+                    CopyPixel<C>(p, out);
+                }
+            }
+        }
+
+        /// same as MirrorRows, in place: each row is swapped with its mirror, each pixel with its mirror in there
+        template <int C, typename T>
+        void MirrorRowsInPlace(BitmapData<T>& image, const bool mirrorRows, const bool mirrorPixels)
+        {
+            const int width  = image.Width();
+            const int height = image.Height();
+            const int rows   = mirrorRows ? (height + 1) / 2 : height;
+
+#pragma omp parallel for
+            for (int y = 0; y < rows; ++y)
+            {
+                T* a = image.Buffer() + (size_t)y * width * C;
+                T* b = image.Buffer() + (size_t)(mirrorRows ? height - 1 - y : y) * width * C;
+
+                if (!mirrorPixels)
+                {
+                    if (a != b)
+                    {
+                        std::swap_ranges(a, a + (size_t)width * C, b);
+                    }
+                    continue;
+                }
+
+                // the middle row, like every row of a horizontal flip, is reversed within itself
+                const int n = a == b ? width / 2 : width;
+                for (int x = 0; x < n; ++x)
+                {
+                    SwapPixels<C>(a + (size_t)x * C, b + (size_t)(width - 1 - x) * C);
+                }
+            }
+        }
+
+        template <typename T>
+        void CheckOrientationTarget(const char* name, const BitmapData<T>& source, const BitmapData<T>& destination, const int width, const int height)
+        {
+            if (&source == &destination)
+            {
+                throw std::runtime_error(std::string("acrion::image::") + name + ": source and destination are the same image, use the InPlace variant");
+            }
+
+            if (destination.Width() != width || destination.Height() != height || destination.Channels() != source.Channels())
+            {
+                throw std::runtime_error(std::string("acrion::image::") + name + ": destination must have " + std::to_string(width) + " x " + std::to_string(height) + " pixels of " + std::to_string(source.Channels()) + " channels");
+            }
+        }
+
+        template <typename T>
+        void FinishOrientation(const BitmapData<T>& source, BitmapData<T>& destination)
+        {
+            destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+            destination.Invalidate();
+        }
+    }
+
+    /// Writes `source` with rows and columns exchanged to `destination`, which must have the transposed size.
+    template <typename T>
+    void Transpose(const BitmapData<T>& source, BitmapData<T>& destination)
+    {
+        detail::CheckOrientationTarget("Transpose", source, destination, source.Height(), source.Width());
+        detail::WithChannels(source.Channels(), [&](auto channels)
+        {
+            detail::TransposeTiles<decltype(channels)::value>(source, destination, false, false);
+        });
+        detail::FinishOrientation(source, destination);
+    }
+
+    template <typename T>
+    BitmapData<T> Transpose(const BitmapData<T>& source)
+    {
+        BitmapData<T> destination(source.Height(), source.Width(), source.Channels());
+        Transpose(source, destination);
+        return destination;
+    }
+
+    /// Transposes a square image in place; throws for other sizes.
+    template <typename T>
+    void TransposeInPlace(BitmapData<T>& image)
+    {
+        if (image.Width() != image.Height())
+        {
+            throw std::runtime_error("acrion::image::TransposeInPlace: image of " + std::to_string(image.Width()) + " x " + std::to_string(image.Height()) + " pixels is not square");
+        }
+
+        detail::WithChannels(image.Channels(), [&](auto channels)
+        {
+            detail::TransposeTilesInPlace<decltype(channels)::value>(image);
+        });
+        image.Invalidate();
+    }
+
+    /// Writes `source` rotated clockwise by `rotation` to `destination`, which must have the rotated size.
+    template <typename T>
+    void Rotate(const BitmapData<T>& source, BitmapData<T>& destination, const Rotation rotation)
+    {
+        const bool quarter = rotation != Rotation::Rotate180;
+
+        detail::CheckOrientationTarget("Rotate", source, destination, quarter ? source.Height() : source.Width(), quarter ? source.Width() : source.Height());
+        detail::WithChannels(source.Channels(), [&](auto channels)
+        {
+            constexpr int C = decltype(channels)::value;
+
+            if (quarter)
+            {
+                detail::TransposeTiles<C>(source, destination, rotation == Rotation::Rotate90, rotation == Rotation::Rotate270);
+            }
+            else
+            {
+                detail::MirrorRows<C>(source, destination, true, true);
+            }
+        });
+        detail::FinishOrientation(source, destination);
+    }
+
+    template <typename T>
+    BitmapData<T> Rotate(const BitmapData<T>& source, const Rotation rotation)
+    {
+        const bool    quarter = rotation != Rotation::Rotate180;
+        BitmapData<T> destination(quarter ? source.Height() : source.Width(), quarter ? source.Width() : source.Height(), source.Channels());
+        Rotate(source, destination, rotation);
+        return destination;
+    }
+
+    /// Rotates in place; rotations by 90 and 270 degrees require a square image and throw otherwise.
+    template <typename T>
+    void RotateInPlace(BitmapData<T>& image, const Rotation rotation)
+    {
+        if (rotation != Rotation::Rotate180)
+        {
+            // a transpose followed by a horizontal (90) or vertical (270) flip
+            TransposeInPlace(image);
+        }
+
+        detail::WithChannels(image.Channels(), [&](auto channels)
+        {
+            detail::MirrorRowsInPlace<decltype(channels)::value>(image, rotation != Rotation::Rotate90, rotation != Rotation::Rotate270);
+        });
+        image.Invalidate();
+    }
+
+    /// Writes `source` mirrored in `direction` to `destination`, which must have the same size.
+    template <typename T>
+    void Flip(const BitmapData<T>& source, BitmapData<T>& destination, const FlipDirection direction)
+    {
+        detail::CheckOrientationTarget("Flip", source, destination, source.Width(), source.Height());
+        detail::WithChannels(source.Channels(), [&](auto channels)
+        {
+            detail::MirrorRows<decltype(channels)::value>(source, destination, direction == FlipDirection::Vertical, direction == FlipDirection::Horizontal);
+        });
+        detail::FinishOrientation(source, destination);
+    }
+
+    template <typename T>
+    BitmapData<T> Flip(const BitmapData<T>& source, const FlipDirection direction)
+    {
+        BitmapData<T> destination(source.Width(), source.Height(), source.Channels());
+        Flip(source, destination, direction);
+        return destination;
+    }
+
+    template <typename T>
+    void FlipInPlace(BitmapData<T>& image, const FlipDirection direction)
+    {
+        detail::WithChannels(image.Channels(), [&](auto channels)
+        {
+            detail::MirrorRowsInPlace<decltype(channels)::value>(image, direction == FlipDirection::Vertical, direction == FlipDirection::Horizontal);
+        });
+        image.Invalidate();
+    }
+}
@@ -0,0 +1,273 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        /// sub-pixel resolution of a RemapTable, in steps per pixel
+        constexpr int remapSteps = 32;
+
+        /// scale of the fixed-point bilinear weights used for 8 and 16 bit samples
+        constexpr int remapWeightBits = 15;
+
+        /// The bilinear weights of the four taps (top left, top right, bottom left, bottom right) for the offsets
+        /// (i, j) / remapSteps, at index j * (remapSteps + 1) + i. The weights of each entry sum up to exactly
+        /// 1 << remapWeightBits.
+        inline const std::vector<std::array<uint32_t, 4>>& RemapFixedWeights()
+        {
+            static const std::vector<std::array<uint32_t, 4>> table = []
+            {
+                std::vector<std::array<uint32_t, 4>> weights((remapSteps + 1) * (remapSteps + 1));
+                for (int j = 0; j <= remapSteps; ++j)
+                {
+                    for (int i = 0; i <= remapSteps; ++i)
+                    {
+                        const double x   = (double)i / remapSteps;
+                        const double y   = (double)j / remapSteps;
+                        const double one = 1 << remapWeightBits;
+
+                        std::array<uint32_t, 4>& w = weights[j * (remapSteps + 1) + i];
+                        w[1]                       = (uint32_t)std::lround(x * (1 - y) * one);
+                        w[2]                       = (uint32_t)std::lround((1 - x) * y * one);
+                        w[3]                       = (uint32_t)std::lround(x * y * one);
+                        w[0]                       = (1u << remapWeightBits) - w[1] - w[2] - w[3];
+                    }
+                }
+                return weights;
+            }();
+
+            return table;
+        }
+    }
+
+    /// A coordinate map for Remap, converted once into fixed point: per destination pixel the 32 bit index of the
+    /// top left source pixel of the bilinear cell and the 16 bit index of the sub-pixel offset, rounded to 1/32
+    /// pixel; 6 bytes per pixel, so that large tables stay cheap to stream. Applying it to a frame costs one
+    /// gather of four pixels and a weighted sum, independent of how the map was computed.
+    class RemapTable
+    {
+    public:
+        /// `mapX` and `mapY` hold the source position of each destination pixel (row by row, `width` * `height`
+        /// entries). Pixel centres are at integer coordinates; positions further than half a pixel outside the
+        /// source, or not finite, get the fill value of Remap. Sources may have up to 2^31 pixels.
+        RemapTable(const std::vector<float>& mapX, const std::vector<float>& mapY, const int width, const int height, const int sourceWidth, const int sourceHeight)
+            : _width(width)
+            , _height(height)
+            , _sourceWidth(sourceWidth)
+            , _sourceHeight(sourceHeight)
+            , _stepX(sourceWidth > 1 ? 1 : 0)
+            , _stepY(sourceHeight > 1 ? sourceWidth : 0)
+        {
+            const size_t size = (size_t)width * height;
+
+            if (width < 0 || height < 0 || mapX.size() != size || mapY.size() != size)
+            {
+                throw std::runtime_error("acrion::image::RemapTable: maps of " + std::to_string(mapX.size()) + " and " + std::to_string(mapY.size()) + " entries do not match " + std::to_string(width) + " x " + std::to_string(height) + " pixels");
+            }
+
+            if (sourceWidth <= 0 || sourceHeight <= 0)
+            {
+                throw std::runtime_error("acrion::image::RemapTable: source image is empty");
+            }
+
+            if ((int64_t)sourceWidth * sourceHeight > (int64_t(1) << 31))
+            {
+                throw std::runtime_error("acrion::image::RemapTable: source of " + std::to_string(sourceWidth) + " x " + std::to_string(sourceHeight) + " pixels exceeds the 2^31 pixels addressable by the table");
+            }
+
+            _positions.resize(size);
+            _weights.resize(size);
+
+#pragma omp parallel for
+            for (int y = 0; y < height; ++y)
+            {
+                for (size_t k = (size_t)y * width; k < (size_t)(y + 1) * width; ++k)
+                {
+                    int       i;
+                    int       j;
+                    const int ix = Cell(mapX[k], sourceWidth, i);
+                    const int iy = Cell(mapY[k], sourceHeight, j);
+
+                    _positions[k] = ix < 0 || iy < 0 ? -1 : (int32_t)((int64_t)iy * sourceWidth + ix);
+                    _weights[k]   = (uint16_t)(j * (detail::remapSteps + 1) + i);
+                }
+            }
+        }
+
+        /// Evaluates `f(int x, int y)`, which returns the source position {sx, sy} of destination pixel (x, y).
+        template <typename Function>
+        static RemapTable FromFunction(const int width, const int height, const int sourceWidth, const int sourceHeight, Function f)
+        {
+            std::vector<float> mapX((size_t)width * height);
+            std::vector<float> mapY((size_t)width * height);
+
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    const std::array<double, 2> position = f(x, y);
+                    mapX[(size_t)y * width + x]          = (float)position[0];
+                    mapY[(size_t)y * width + x]          = (float)position[1];
+                }
+            }
+
+            return RemapTable(mapX, mapY, width, height, sourceWidth, sourceHeight);
+        }
+
+        int Width() const { return _width; }
+        int Height() const { return _height; }
+        int SourceWidth() const { return _sourceWidth; }
+        int SourceHeight() const { return _sourceHeight; }
+
+        /// source pixel index (y * SourceWidth() + x) of the top left tap per destination pixel, -1 for fill
+        const std::vector<int32_t>& Positions() const { return _positions; }
+
+        /// index into detail::RemapFixedWeights() per destination pixel
+        const std::vector<uint16_t>& Weights() const { return _weights; }
+
+        /// pixel offsets from the top left tap to its right and lower neighbours (0 for a single column or row)
+        int StepX() const { return _stepX; }
+        int StepY() const { return _stepY; }
+
+    private:
+        /// The first tap of the cell containing `s` in [0, size), with the offset into it in 1/remapSteps in `step`;
+        /// -1 if `s` is outside the source. The last pixel is reached as the right tap of the last cell.
+        static int Cell(const float s, const int size, int& step)
+        {
+            step = 0;
+
+            if (!(s >= -0.5f && s < size - 0.5f))
+            {
+                return -1;
+            }
+
+            if (size == 1)
+            {
+                return 0;
+            }
+
+            const double clamped = std::min((double)size - 1, std::max(0.0, (double)s));
+            const int    first   = std::min(size - 2, (int)clamped);
+            step                 = (int)std::lround((clamped - first) * detail::remapSteps);
+            return first;
+        }
+
+        int                   _width;
+        int                   _height;
+        int                   _sourceWidth;
+        int                   _sourceHeight;
+        int                   _stepX;
+        int                   _stepY;
+        std::vector<int32_t>  _positions;
+        std::vector<uint16_t> _weights;
+    };
+
+    /// Fills `destination`, which must have the size of `table`, with `source` sampled bilinearly at the positions
+    /// of `table`; pixels that map outside the source get `fill` in all channels. 8 and 16 bit samples are mixed in
+    /// integer arithmetic, all other types in double precision.
+    template <typename T>
+    void Remap(const BitmapData<T>& source, BitmapData<T>& destination, const RemapTable& table, const double fill = 0)
+    {
+        if (source.Width() != table.SourceWidth() || source.Height() != table.SourceHeight())
+        {
+            throw std::runtime_error("acrion::image::Remap: table is for a source of " + std::to_string(table.SourceWidth()) + " x " + std::to_string(table.SourceHeight()) + " pixels, source has " + std::to_string(source.Width()) + " x " + std::to_string(source.Height()));
+        }
+
+        if (destination.Width() != table.Width() || destination.Height() != table.Height() || destination.Channels() != source.Channels())
+        {
+            throw std::runtime_error("acrion::image::Remap: destination does not match the table size or the channels of the source");
+        }
+
+        const int channels = source.Channels();
+        const int width    = table.Width();
+        const T   value    = detail::ToSample<T>(fill);
+
+        const std::vector<std::array<uint32_t, 4>>& weights   = detail::RemapFixedWeights();
+        const std::vector<int32_t>&                 positions = table.Positions();
+        const std::vector<uint16_t>&                steps     = table.Weights();
+        const size_t                                right     = (size_t)table.StepX() * channels;
+        const size_t                                down      = (size_t)table.StepY() * channels;
+
+#pragma omp parallel for
+        for (int y = 0; y < table.Height(); ++y)
+        {
+            T* out = destination.Buffer() + (size_t)y * width * channels;
+
+            for (size_t k = (size_t)y * width; k < (size_t)(y + 1) * width; ++k, out += channels)
+            {
+                if (positions[k] < 0)
+                {
+                    std::fill(out, out + channels, value);
+                    continue;
+                }
+
+                const T*                       a = source.Buffer() + (size_t)positions[k] * channels;
+                const T*                       c = a + down;
+                const std::array<uint32_t, 4>& w = weights[steps[k]];
+
+                for (int ch = 0; ch < channels; ++ch)
+                {
+                    if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>)
+                    {
+                        // at most 65535 * 2^15 plus rounding, which fits into 32 bits
+                        const uint32_t sum = w[0] * a[ch] + w[1] * a[right + ch] + w[2] * c[ch] + w[3] * c[right + ch];
+                        out[ch]            = (T)((sum + (1u << (detail::remapWeightBits - 1))) >> detail::remapWeightBits);
+                    }
+                    else
+                    {
+                        const double sum = (double)w[0] * a[ch] + (double)w[1] * a[right + ch] + (double)w[2] * c[ch] + (double)w[3] * c[right + ch];
+                        out[ch]          = detail::ToSample<T>(std::ldexp(sum, -detail::remapWeightBits));
+                    }
+                }
+            }
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    template <typename T>
+    BitmapData<T> Remap(const BitmapData<T>& source, const RemapTable& table, const double fill = 0)
+    {
+        BitmapData<T> destination(table.Width(), table.Height(), source.Channels());
+        Remap(source, destination, table, fill);
+        return destination;
+    }
+}
@@ -0,0 +1,308 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    enum class ResampleFilter
+    {
+        Nearest,  // one source pixel per destination pixel, no filtering
+        Box,      // unweighted mean of the whole source pixels covered by the destination pixel
+        Area,     // mean weighted by the exact fractional coverage of each source pixel
+        Bilinear, // linear interpolation between the two source pixels next to the destination pixel centre
+        Bicubic,  // Keys cubic convolution (a = -0.5) over 4 source pixels, widened by the reduction factor
+        Lanczos3, // windowed sinc over 6 source pixels, widened by the reduction factor
+    };
+
+    namespace detail
+    {
+        /// Keys cubic convolution kernel with a = -0.5, support [-2, 2]
+        inline double CubicKernel(double x)
+        {
+            x = std::abs(x);
+            return x < 1 ? (1.5 * x - 2.5) * x * x + 1 : x < 2 ? ((-0.5 * x + 2.5) * x - 4) * x + 2 : 0.0;
+        }
+
+        /// Lanczos kernel with three lobes, support [-3, 3]
+        inline double Lanczos3Kernel(const double x)
+        {
+            constexpr double pi = 3.14159265358979323846;
+
+            if (x == 0)
+            {
+                return 1.0;
+            }
+            if (std::abs(x) >= 3)
+            {
+                return 0.0;
+            }
+            return 3 * std::sin(pi * x) * std::sin(pi * x / 3) / (pi * pi * x * x);
+        }
+
+        /// Precomputed taps of one axis of a separable resampling: destination index i reads `count[i]` consecutive
+        /// source indices starting at `first[i]`, with the weights at `weights[offset[i]]`. Taps outside the source
+        /// are dropped and the remaining weights renormalised; a count of 0 means no source pixel contributes.
+        struct ResampleAxis
+        {
+            std::vector<int>    first;
+            std::vector<int>    count;
+            std::vector<size_t> offset;
+            std::vector<double> weights;
+
+            int Size() const { return (int)first.size(); }
+        };
+
+        /// Maps the span [sourceBegin, sourceBegin + sourceSize) of an axis with `sourceLimit` pixels onto `destSize`
+        /// destination pixels.
+        inline ResampleAxis MakeResampleAxis(const ResampleFilter filter, const int destSize, const int sourceBegin, const int sourceSize, const int sourceLimit)
+        {
+            ResampleAxis axis;
+            axis.first.resize(destSize);
+            axis.count.resize(destSize);
+            axis.offset.resize(destSize);
+
+            const double        scale = (double)sourceSize / destSize;
+            std::vector<int>    taps;
+            std::vector<double> tapWeights;
+
+            for (int i = 0; i < destSize; ++i)
+            {
+                taps.clear();
+                tapWeights.clear();
+
+                switch (filter)
+                {
+                case ResampleFilter::Nearest:
+                    taps.push_back(sourceBegin + (int)std::lround(static_cast<double>(i) * sourceSize / destSize));
+                    tapWeights.push_back(1.0);
+                    break;
+                case ResampleFilter::Box:
+                {
+                    const int begin = sourceBegin + (int)((int64_t)i * sourceSize / destSize);
+                    const int end   = std::max(begin + 1, sourceBegin + (int)((int64_t)(i + 1) * sourceSize / destSize));
+                    for (int k = begin; k < end; ++k)
+                    {
+                        taps.push_back(k);
+                        tapWeights.push_back(1.0);
+                    }
+                    break;
+                }
+                case ResampleFilter::Area:
+                {
+                    const double begin = sourceBegin + i * scale;
+                    const double end   = begin + scale;
+                    for (int k = (int)std::floor(begin); k < end; ++k)
+                    {
+                        const double coverage = std::min(end, k + 1.0) - std::max(begin, (double)k);
+                        if (coverage > 1e-9)
+                        {
+                            taps.push_back(k);
+                            tapWeights.push_back(coverage);
+                        }
+                    }
+                    break;
+                }
+                case ResampleFilter::Bilinear:
+                {
+                    const double centre = sourceBegin + (i + 0.5) * scale - 0.5;
+                    const int    k      = (int)std::floor(centre);
+                    const double f      = centre - k;
+                    taps.push_back(k);
+                    tapWeights.push_back(1.0 - f);
+                    taps.push_back(k + 1);
+                    tapWeights.push_back(f);
+                    break;
+                }
+                case ResampleFilter::Bicubic:
+                case ResampleFilter::Lanczos3:
+                {
+                    // when reducing, the kernel is stretched so that it also acts as low pass
+                    const double stretch = std::max(1.0, scale);
+                    const double support = (filter == ResampleFilter::Bicubic ? 2.0 : 3.0) * stretch;
+                    const double centre  = sourceBegin + (i + 0.5) * scale - 0.5;
+                    for (int k = (int)std::ceil(centre - support); k <= (int)std::floor(centre + support); ++k)
+                    {
+                        const double d = (k - centre) / stretch;
+                        taps.push_back(k);
+                        tapWeights.push_back(filter == ResampleFilter::Bicubic ? CubicKernel(d) : Lanczos3Kernel(d));
+                    }
+                    break;
+                }
+                }
+
+                // drop taps outside the source and merge duplicates; negative lobes are kept
+                int    first = 0;
+                int    last  = -1;
+                double sum   = 0;
+                for (size_t t = 0; t < taps.size(); ++t)
+                {
+                    if (taps[t] >= 0 && taps[t] < sourceLimit && tapWeights[t] != 0)
+                    {
+                        if (last < first)
+                        {
+                            first = taps[t];
+                        }
+                        last = taps[t];
+                        sum += tapWeights[t];
+                    }
+                }
+
+                axis.offset[i] = axis.weights.size();
+
+                if (last < first || sum <= 0)
+                {
+                    axis.first[i] = 0;
+                    axis.count[i] = 0;
+                    continue;
+                }
+
+                // one pass over the taps; duplicates add up in the slot of their source pixel
+                const size_t offset = axis.weights.size();
+                axis.first[i]       = first;
+                axis.count[i]       = last - first + 1;
+                axis.weights.resize(offset + axis.count[i], 0.0);
+                for (size_t t = 0; t < taps.size(); ++t)
+                {
+                    if (taps[t] >= first && taps[t] <= last)
+                    {
+                        axis.weights[offset + (taps[t] - first)] += tapWeights[t];
+                    }
+                }
+                for (int k = 0; k < axis.count[i]; ++k)
+                {
+                    axis.weights[offset + k] /= sum;
+                }
+            }
+
+            return axis;
+        }
+
+        /// The taps of a horizontal ResampleAxis for every interleaved sample of a row, padded to the largest tap
+        /// count, so that the horizontal pass runs as one vector loop per tap over all samples of the row. Padding
+        /// taps precede the real ones with weight 0; the first tap is moved left where needed to stay in the row.
+        template <typename W>
+        struct RowTaps
+        {
+            int              taps{0};
+            int              channels{1};
+            std::vector<int> start;   // index of the first tap of sample k in the source row
+            std::vector<W>   weights; // weight of tap t of sample k at t * start.size() + k
+        };
+
+        template <typename W>
+        RowTaps<W> MakeRowTaps(const ResampleAxis& axis, const std::vector<W>& axisWeights, const int channels, const int sourceWidth)
+        {
+            RowTaps<W> row;
+            row.taps     = axis.count.empty() ? 0 : *std::max_element(axis.count.begin(), axis.count.end());
+            row.channels = channels;
+
+            const size_t n = (size_t)axis.Size() * channels;
+            row.start.resize(n);
+            row.weights.assign((size_t)row.taps * n, W(0));
+
+            for (int i = 0; i < axis.Size(); ++i)
+            {
+                const int first = std::max(0, std::min(axis.first[i], sourceWidth - row.taps));
+                const int shift = axis.first[i] - first;
+
+                for (int c = 0; c < channels; ++c)
+                {
+                    const size_t k = (size_t)i * channels + c;
+                    row.start[k]   = first * channels + c;
+
+                    for (int t = 0; t < axis.count[i]; ++t)
+                    {
+                        row.weights[(size_t)(shift + t) * n + k] = axisWeights[axis.offset[i] + t];
+                    }
+                }
+            }
+
+            return row;
+        }
+
+        /// Adds the weighted taps of `row` in the source row `src` to the samples of `sum`, in the order of the taps.
+        template <typename S, typename T, typename W>
+        void AddRowTaps(const T* src, const RowTaps<W>& row, S* sum)
+        {
+            const int  n     = (int)row.start.size();
+            const int* start = row.start.data();
+
+            for (int t = 0; t < row.taps; ++t)
+            {
+                const W* w = row.weights.data() + (size_t)t * n;
+                const T* p = src + (size_t)t * row.channels;
+
+#pragma omp simd
+                for (int k = 0; k < n; ++k)
+                {
+                    sum[k] += (S)w[k] * (S)p[start[k]];
+                }
+            }
+        }
+
+        /// Resamples one interleaved row horizontally into `out` (taps.start.size() values).
+        template <typename T>
+        void ResampleRow(const T* src, const RowTaps<double>& taps, double* out)
+        {
+            std::fill(out, out + taps.start.size(), 0.0);
+            AddRowTaps(src, taps, out);
+        }
+
+        /// Rounds a resampled value to the nearest sample value, saturating to the range of T.
+        template <typename T>
+        inline T ToSample(const double v)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return (T)v;
+            }
+            else
+            {
+                const double rounded = std::floor(v + 0.5);
+
+                if (rounded <= 0)
+                {
+                    return 0;
+                }
+
+                if (rounded >= std::ldexp(1.0, std::numeric_limits<T>::digits))
+                {
+                    return std::numeric_limits<T>::max();
+                }
+
+                return (T)rounded;
+            }
+        }
+    }
+}
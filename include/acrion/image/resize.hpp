@@ -0,0 +1,304 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    namespace detail
+    {
+        /// The weights of `axis` in fixed point with `bits` fractional bits. The weights of every destination pixel
+        /// sum up to exactly 1 << bits; the rounding error is put on the largest weight.
+        inline std::vector<int32_t> FixedResampleWeights(const ResampleAxis& axis, const int bits)
+        {
+            std::vector<int32_t> fixed(axis.weights.size());
+
+            for (int i = 0; i < axis.Size(); ++i)
+            {
+                const size_t offset  = axis.offset[i];
+                int32_t      sum     = 0;
+                size_t       largest = offset;
+
+                for (int t = 0; t < axis.count[i]; ++t)
+                {
+                    fixed[offset + t] = (int32_t)std::lround(std::ldexp(axis.weights[offset + t], bits));
+                    sum += fixed[offset + t];
+                    if (axis.weights[offset + t] > axis.weights[largest])
+                    {
+                        largest = offset + t;
+                    }
+                }
+
+                if (axis.count[i] > 0)
+                {
+                    fixed[largest] += (1 << bits) - sum;
+                }
+            }
+
+            return fixed;
+        }
+
+        /// Nearest neighbour taps at the source pixel under each destination pixel centre. The Nearest axis of the
+        /// display path rounds i * scale instead, which it keeps for compatibility, but which can step past the last
+        /// source pixel when enlarging.
+        inline ResampleAxis NearestResizeAxis(const int destSize, const int sourceSize)
+        {
+            ResampleAxis axis;
+            axis.first.resize(destSize);
+            axis.count.assign(destSize, 1);
+            axis.offset.resize(destSize);
+            axis.weights.assign(destSize, 1.0);
+
+            for (int i = 0; i < destSize; ++i)
+            {
+                axis.first[i]  = std::min(sourceSize - 1, (int)(((int64_t)2 * i + 1) * sourceSize / (2 * (int64_t)destSize)));
+                axis.offset[i] = i;
+            }
+
+            return axis;
+        }
+
+        /// Runs the two passes over bands of output rows in parallel. The horizontal pass of a source row goes into a
+        /// per-thread ring with as many rows as the largest vertical tap count, where it stays until the rows of the
+        /// band no longer read it; so the memory needed grows with the filter support instead of the source height.
+        /// `horizontal(y, out, scratch)` resamples source row y into `out`, `vertical(j, in, scratch)` computes
+        /// output row j from the rows `in` of its taps; `scratch` holds n values of S for both.
+        template <typename I, typename S, typename Horizontal, typename Vertical>
+        void ResizeInBands(const ResampleAxis& rows, const int sourceHeight, const int n, Horizontal horizontal, Vertical vertical)
+        {
+            const int ringSize = std::max(1, *std::max_element(rows.count.begin(), rows.count.end()));
+
+            // bands span about 8 rings of source rows, which bounds the rows resampled twice at band borders
+            const int bandRows = (int)std::max<int64_t>(1, (int64_t)8 * ringSize * rows.Size() / sourceHeight);
+            const int bands    = (rows.Size() + bandRows - 1) / bandRows;
+
+#pragma omp parallel
+            {
+                std::vector<I>        ring((size_t)ringSize * n);
+                std::vector<int>      held(ringSize, -1); // source row in each slot of the ring
+                std::vector<const I*> in(ringSize);
+                std::vector<S>        scratch(n);
+
+#pragma omp for schedule(dynamic)
+                for (int band = 0; band < bands; ++band)
+                {
+                    const int end = std::min(rows.Size(), (band + 1) * bandRows);
+
+                    for (int j = band * bandRows; j < end; ++j)
+                    {
+                        for (int t = 0; t < rows.count[j]; ++t)
+                        {
+                            const int y    = rows.first[j] + t;
+                            const int slot = y % ringSize;
+                            I*        row  = ring.data() + (size_t)slot * n;
+
+                            if (held[slot] != y)
+                            {
+                                horizontal(y, row, scratch.data());
+                                held[slot] = y;
+                            }
+                            in[t] = row;
+                        }
+
+                        vertical(j, in.data(), scratch.data());
+                    }
+                }
+            }
+        }
+
+        /// Resize of 8 and 16 bit samples in integer arithmetic. The horizontal pass keeps `intermediateBits`
+        /// fractional bits, which the vertical pass removes together with its own weight scale.
+        template <typename T>
+        void ResizeFixed(const BitmapData<T>& source, BitmapData<T>& destination, const ResampleAxis& columns, const ResampleAxis& rows)
+        {
+            using Accumulator = std::conditional_t<sizeof(T) == 1, int32_t, int64_t>;
+
+            constexpr int weightBits       = sizeof(T) == 1 ? 14 : 22;
+            constexpr int intermediateBits = sizeof(T) == 1 ? 6 : 8;
+            constexpr int horizontalShift  = weightBits - intermediateBits;
+            constexpr int verticalShift    = weightBits + intermediateBits;
+            constexpr int maxValue         = std::numeric_limits<T>::max();
+
+            const int    channels    = source.Channels();
+            const int    n           = destination.Width() * channels;
+            const size_t sourceWidth = (size_t)source.Width() * channels;
+
+            const RowTaps<int32_t>     columnTaps = MakeRowTaps(columns, FixedResampleWeights(columns, weightBits), channels, source.Width());
+            const std::vector<int32_t> rowWeights = FixedResampleWeights(rows, weightBits);
+
+            const auto horizontal = [&](const int y, int32_t* out, Accumulator* sum)
+            {
+                std::fill(sum, sum + n, Accumulator(1) << (horizontalShift - 1));
+                AddRowTaps(source.Buffer() + (size_t)y * sourceWidth, columnTaps, sum);
+
+#pragma omp simd
+                for (int k = 0; k < n; ++k)
+                {
+                    out[k] = (int32_t)(sum[k] >> horizontalShift);
+                }
+            };
+
+            const auto vertical = [&](const int j, const int32_t* const* in, Accumulator* sum)
+            {
+                const int32_t* w = rowWeights.data() + rows.offset[j];
+
+                std::fill(sum, sum + n, Accumulator(1) << (verticalShift - 1));
+
+                for (int t = 0; t < rows.count[j]; ++t)
+                {
+                    const int32_t* row    = in[t];
+                    const int32_t  weight = w[t];
+
+#pragma omp simd
+                    for (int k = 0; k < n; ++k)
+                    {
+                        sum[k] += (Accumulator)weight * row[k];
+                    }
+                }
+
+                T* dest = destination.Buffer() + (size_t)j * n;
+
+#pragma omp simd
+                for (int k = 0; k < n; ++k)
+                {
+                    const Accumulator v = sum[k] >> verticalShift;
+                    dest[k]             = (T)(v < 0 ? 0 : v > maxValue ? maxValue : v);
+                }
+            };
+
+            ResizeInBands<int32_t, Accumulator>(rows, source.Height(), n, horizontal, vertical);
+        }
+
+        /// Resize of all other sample types in double precision.
+        template <typename T>
+        void ResizeFloating(const BitmapData<T>& source, BitmapData<T>& destination, const ResampleAxis& columns, const ResampleAxis& rows)
+        {
+            const int    channels    = source.Channels();
+            const int    n           = destination.Width() * channels;
+            const size_t sourceWidth = (size_t)source.Width() * channels;
+
+            const RowTaps<double> columnTaps = MakeRowTaps(columns, columns.weights, channels, source.Width());
+
+            const auto horizontal = [&](const int y, double* out, double*)
+            {
+                ResampleRow(source.Buffer() + (size_t)y * sourceWidth, columnTaps, out);
+            };
+
+            const auto vertical = [&](const int j, const double* const* in, double* sum)
+            {
+                const double* w = rows.weights.data() + rows.offset[j];
+
+                std::fill(sum, sum + n, 0.0);
+
+                for (int t = 0; t < rows.count[j]; ++t)
+                {
+                    const double* row    = in[t];
+                    const double  weight = w[t];
+
+#pragma omp simd
+                    for (int k = 0; k < n; ++k)
+                    {
+                        sum[k] += weight * row[k];
+                    }
+                }
+
+                T* dest = destination.Buffer() + (size_t)j * n;
+                for (int k = 0; k < n; ++k)
+                {
+                    dest[k] = ToSample<T>(sum[k]);
+                }
+            };
+
+            ResizeInBands<double, double>(rows, source.Height(), n, horizontal, vertical);
+        }
+    }
+
+    /// Resamples `source` to the size of `destination`, which must be a different image with the same number of
+    /// channels, in two separable passes (horizontal, then vertical) with precomputed weights per column and row.
+    /// The passes run in parallel over bands of output rows and keep only the source rows that the vertical filter
+    /// still needs, so the extra memory is a few rows per thread instead of a full-height intermediate image. 8 and
+    /// 16 bit images are filtered in integer arithmetic (14 and 22 bit weights), all other types in double
+    /// precision; results of Bicubic and Lanczos3, which overshoot at edges, saturate to the range of T. Alpha is
+    /// filtered like any other channel, so premultiply ARGB images first if transparent pixels carry colour.
+    template <typename T>
+    void Resize(const BitmapData<T>& source, BitmapData<T>& destination, const ResampleFilter filter = ResampleFilter::Bilinear)
+    {
+        if (source.Channels() != destination.Channels())
+        {
+            throw std::runtime_error("acrion::image::Resize: source has " + std::to_string(source.Channels()) + " channels, destination " + std::to_string(destination.Channels()));
+        }
+
+        if (source.Buffer() == destination.Buffer())
+        {
+            throw std::runtime_error("acrion::image::Resize: source and destination are the same image");
+        }
+
+        if (destination.Width() <= 0 || destination.Height() <= 0)
+        {
+            return;
+        }
+
+        if (source.Width() <= 0 || source.Height() <= 0)
+        {
+            throw std::runtime_error("acrion::image::Resize: source image is empty");
+        }
+
+        const bool                 nearest = filter == ResampleFilter::Nearest;
+        const detail::ResampleAxis columns = nearest ? detail::NearestResizeAxis(destination.Width(), source.Width()) : detail::MakeResampleAxis(filter, destination.Width(), 0, source.Width(), source.Width());
+        const detail::ResampleAxis rows    = nearest ? detail::NearestResizeAxis(destination.Height(), source.Height()) : detail::MakeResampleAxis(filter, destination.Height(), 0, source.Height(), source.Height());
+
+        if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>)
+        {
+            detail::ResizeFixed(source, destination, columns, rows);
+        }
+        else
+        {
+            detail::ResizeFloating(source, destination, columns, rows);
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    template <typename T>
+    BitmapData<T> Resize(const BitmapData<T>& source, const int width, const int height, const ResampleFilter filter = ResampleFilter::Bilinear)
+    {
+        BitmapData<T> destination(width, height, source.Channels());
+        Resize(source, destination, filter);
+        return destination;
+    }
+}
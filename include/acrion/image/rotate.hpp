@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "orientation.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace acrion::image
+{
+    enum class RotateBounds
+    {
+        Crop,   // the size of the source; the corners of the rotated image are cut off
+        Expand, // large enough for the whole rotated source
+    };
+
+    namespace detail
+    {
+        /// Samples the row `in` (inWidth pixels) linearly at positions i + shift for i in [0, outWidth). Taps outside
+        /// the row read `fill`. Between the borders, all pixels share the same two weights, so the loop runs over
+        /// the interleaved samples and vectorises.
+        template <typename S, typename I>
+        void ShiftRow(const S* in, const int inWidth, I* out, const int outWidth, const int channels, const double shift, const I fill)
+        {
+            const int k     = (int)std::floor(shift);
+            const I   b     = (I)(shift - k);
+            const I   a     = 1 - b;
+            const int first = std::min(outWidth, std::max(0, -k));
+            const int last  = std::max(first, std::min(outWidth, inWidth - 1 - k));
+
+            const auto border = [&](const int i)
+            {
+                for (int c = 0; c < channels; ++c)
+                {
+                    const int x0 = i + k;
+                    const int x1 = x0 + 1;
+                    const I   v0 = x0 >= 0 && x0 < inWidth ? (I)in[(size_t)x0 * channels + c] : fill;
+                    const I   v1 = x1 >= 0 && x1 < inWidth ? (I)in[(size_t)x1 * channels + c] : fill;
+
+                    out[(size_t)i * channels + c] = a * v0 + b * v1;
+                }
+            };
+
+            for (int i = 0; i < first; ++i)
+            {
+                border(i);
+            }
+
+            const S*  p = in + (ptrdiff_t)(first + k) * channels;
+            I*        o = out + (size_t)first * channels;
+            const int n = (last - first) * channels;
+
+#pragma omp simd
+            for (int e = 0; e < n; ++e)
+            {
+                o[e] = a * (I)p[e] + b * (I)p[e + channels];
+            }
+
+            for (int i = last; i < outWidth; ++i)
+            {
+                border(i);
+            }
+        }
+
+        /// Rotates by |angle| <= 45 degrees as three shears, x by -tan(angle / 2), y by sin(angle), x again
+        /// (Paeth). Every pass shifts whole rows or columns by a sub-pixel amount with linear weights. Each grid
+        /// of the passes maps pixel (i, j) to the centred position (i - ox, j - oy); the source centre maps to the
+        /// destination centre.
+        template <typename T>
+        void RotateByShears(const BitmapData<T>& source, BitmapData<T>& destination, const double angle, const double fill)
+        {
+            // 8 and 16 bit samples are exact in float, wider types keep double precision between the passes
+            using I = std::conditional_t<sizeof(T) <= 2 && !std::is_floating_point_v<T>, float, double>;
+
+            const int    channels = source.Channels();
+            const int    width0   = source.Width();
+            const int    height0  = source.Height();
+            const int    width3   = destination.Width();
+            const int    height3  = destination.Height();
+            const double alpha    = -std::tan(angle / 2);
+            const double beta     = std::sin(angle);
+            const I      value    = (I)fill;
+
+            const double ox0 = (width0 - 1) / 2.0;
+            const double oy0 = (height0 - 1) / 2.0;
+            const double ox3 = (width3 - 1) / 2.0;
+            const double oy3 = (height3 - 1) / 2.0;
+
+            // first pass: rows of the source, wide enough for the sheared source plus one pixel of blending
+            const double reach  = std::abs(alpha) * std::max(oy0, height0 - 1 - oy0);
+            const double ox1    = ox0 + reach + 1;
+            const int    width1 = (int)std::ceil(2 * (reach + 1) + width0 - 1) + 1;
+
+            std::vector<I> grid1((size_t)width1 * height0 * channels);
+
+#pragma omp parallel for
+            for (int j = 0; j < height0; ++j)
+            {
+                ShiftRow(source.Buffer() + (size_t)j * width0 * channels, width0, grid1.data() + (size_t)j * width1 * channels, width1, channels, ox0 - ox1 - alpha * (j - oy0), value);
+            }
+
+            // second pass: columns of the first grid, restricted to the rows of the destination
+            std::vector<int> rowShift(width1);
+            std::vector<I>   rowWeight(width1);
+            for (int i = 0; i < width1; ++i)
+            {
+                const double shift = oy0 - oy3 - beta * (i - ox1);
+                rowShift[i]        = (int)std::floor(shift);
+                rowWeight[i]       = (I)(shift - rowShift[i]);
+            }
+
+            std::vector<I> grid2((size_t)width1 * height3 * channels);
+
+#pragma omp parallel for
+            for (int j = 0; j < height3; ++j)
+            {
+                I* out = grid2.data() + (size_t)j * width1 * channels;
+
+                // neighbouring columns read neighbouring rows, so the accesses stay close in memory
+                for (int i = 0; i < width1; ++i, out += channels)
+                {
+                    const int r0 = j + rowShift[i];
+                    const int r1 = r0 + 1;
+                    const I   b  = rowWeight[i];
+
+                    if (r0 >= 0 && r1 < height0)
+                    {
+                        const I* p = grid1.data() + ((size_t)r0 * width1 + i) * channels;
+                        const I* q = p + (size_t)width1 * channels;
+
+                        for (int c = 0; c < channels; ++c)
+                        {
+                            out[c] = p[c] + b * (q[c] - p[c]);
+                        }
+                    }
+                    else
+                    {
+                        const I* p0 = r0 >= 0 && r0 < height0 ? grid1.data() + ((size_t)r0 * width1 + i) * channels : nullptr;
+                        const I* p1 = r1 >= 0 && r1 < height0 ? grid1.data() + ((size_t)r1 * width1 + i) * channels : nullptr;
+
+                        for (int c = 0; c < channels; ++c)
+                        {
+                            out[c] = (1 - b) * (p0 ? p0[c] : value) + b * (p1 ? p1[c] : value);
+                        }
+                    }
+                }
+            }
+
+            // third pass: rows of the second grid into the destination
+#pragma omp parallel
+            {
+                std::vector<I> row((size_t)width3 * channels);
+
+#pragma omp for
+                for (int j = 0; j < height3; ++j)
+                {
+                    ShiftRow(grid2.data() + (size_t)j * width1 * channels, width1, row.data(), width3, channels, ox1 - ox3 - alpha * (j - oy3), value);
+
+                    T* dest = destination.Buffer() + (size_t)j * width3 * channels;
+                    if constexpr (std::is_same_v<I, float>)
+                    {
+                        // same rounding and saturation as ToSample, without branches
+                        constexpr float maxValue = (float)std::numeric_limits<T>::max();
+                        const int       n        = width3 * channels;
+
+#pragma omp simd
+                        for (int e = 0; e < n; ++e)
+                        {
+                            dest[e] = (T)std::min(maxValue, std::max(0.0f, row[e] + 0.5f));
+                        }
+                    }
+                    else
+                    {
+                        for (size_t e = 0; e < row.size(); ++e)
+                        {
+                            dest[e] = ToSample<T>(row[e]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Rotates `source` clockwise (as displayed, with y pointing down) by `angle` in radians around its centre,
+    /// which maps to the centre of `destination`; destination pixels outside the rotated source get `fill`.
+    /// The angle is first reduced to [-45, 45] degrees by an exact quarter turn, the rest is done by three shear
+    /// passes along rows and columns. Each pass interpolates linearly, so the result is slightly softer than a
+    /// single bilinear sample (see WarpAffine for other filters), but it costs a few multiply-adds per sample.
+    template <typename T>
+    void RotateByAngle(const BitmapData<T>& source, BitmapData<T>& destination, const double angle, const double fill = 0)
+    {
+        if (source.Channels() != destination.Channels())
+        {
+            throw std::runtime_error("acrion::image::RotateByAngle: source has " + std::to_string(source.Channels()) + " channels, destination " + std::to_string(destination.Channels()));
+        }
+
+        if (source.Width() <= 0 || source.Height() <= 0)
+        {
+            throw std::runtime_error("acrion::image::RotateByAngle: source image is empty");
+        }
+
+        if (destination.Width() <= 0 || destination.Height() <= 0)
+        {
+            return;
+        }
+
+        const double quarter  = std::acos(0.0);
+        const long   turns    = std::lround(angle / quarter);
+        const double residual = angle - (double)turns * quarter;
+
+        switch (((turns % 4) + 4) % 4)
+        {
+        case 0:
+            detail::RotateByShears(source, destination, residual, fill);
+            break;
+        case 1:
+            detail::RotateByShears(Rotate(source, Rotation::Rotate90), destination, residual, fill);
+            break;
+        case 2:
+            detail::RotateByShears(Rotate(source, Rotation::Rotate180), destination, residual, fill);
+            break;
+        default:
+            detail::RotateByShears(Rotate(source, Rotation::Rotate270), destination, residual, fill);
+            break;
+        }
+
+        destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+        destination.Invalidate();
+    }
+
+    template <typename T>
+    BitmapData<T> RotateByAngle(const BitmapData<T>& source, const double angle, const RotateBounds bounds = RotateBounds::Crop, const double fill = 0)
+    {
+        int width  = source.Width();
+        int height = source.Height();
+
+        if (bounds == RotateBounds::Expand)
+        {
+            // the bounding box of the rotated pixel area; the tolerance keeps exact quarter turns from growing
+            const double c = std::abs(std::cos(angle));
+            const double s = std::abs(std::sin(angle));
+            width          = (int)std::ceil(source.Width() * c + source.Height() * s - 1e-6);
+            height         = (int)std::ceil(source.Width() * s + source.Height() * c - 1e-6);
+        }
+
+        BitmapData<T> destination(width, height, source.Channels());
+        RotateByAngle(source, destination, angle, fill);
+        return destination;
+    }
+}
@@ -30,6 +30,7 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
     #include <math.h> // required for C++ to provide math constants, contradicting both C++ standard and https://docs.microsoft.com/en-us/cpp/c-runtime-library/math-constants?view=msvc-160
 #endif
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -38,7 +39,9 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 #include <memory>
 #include <numeric>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace acrion::image
 {
@@ -93,6 +96,20 @@ namespace acrion::image::utility
     template <typename T>
     T Convert(const long double num);
 
+    template <typename X, typename Arguments, size_t... I>
+    std::array<std::tuple<double, X>, sizeof...(I)> WeightedPairs(const Arguments& arguments, std::index_sequence<I...>)
+    {
+        return {{std::tuple<double, X>(std::get<2 * I>(arguments), std::get<2 * I + 1>(arguments))...}};
+    }
+
+    /// Turns the arguments weight1, value1, weight2, value2, ... into the std::array taken by the Mix methods.
+    template <typename X, typename... Arguments>
+    std::array<std::tuple<double, X>, sizeof...(Arguments) / 2> Weighted(const Arguments&... arguments)
+    {
+        static_assert(sizeof...(Arguments) % 2 == 0, "expected pairs of weight and value");
+        return WeightedPairs<X>(std::forward_as_tuple(arguments...), std::make_index_sequence<sizeof...(Arguments) / 2>{});
+    }
+
     template <>
     inline double Convert(const long double num)
     {
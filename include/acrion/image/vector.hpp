@@ -30,7 +30,10 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
     #include <math.h> // required for C++ to provide math constants, contradicting both C++ standard and https://docs.microsoft.com/en-us/cpp/c-runtime-library/math-constants?view=msvc-160
 #endif
 
+#include "utility.hpp"
+
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <limits>
@@ -83,24 +86,21 @@ namespace acrion::image
         std::pair<double, double> V() { return _v; }
         Vector                    Mix(const std::vector<std::tuple<double, Vector>>& vectors) const
         {
-            double sumW  = 0;
-            double sumVx = 0;
-            double sumVy = 0;
-
-            for (const auto& current : vectors)
-            {
-                const double  weight = std::get<0>(current);
-                const Vector& vector = std::get<1>(current);
-                sumW += weight;
-                sumVx += weight * vector.Vx();
-                sumVy += weight * vector.Vy();
-            }
+            return MixRange(vectors.begin(), vectors.end());
+        }
 
-            const double weight = std::max(0.0, std::min(1.0, 1 - sumW));
+        /// same as above for a fixed number of vectors, without heap allocation
+        template <size_t N>
+        Vector Mix(const std::array<std::tuple<double, Vector>, N>& vectors) const
+        {
+            return MixRange(vectors.begin(), vectors.end());
+        }
 
-            return Vector(std::make_pair(
-                weight * Vx() + sumVx,
-                weight * Vy() + sumVy));
+        /// same as above with the pairs as arguments: a.Mix(0.25, b, 0.5, c)
+        template <typename... Rest>
+        Vector Mix(const double weight, const Vector& vector, const Rest&... rest) const
+        {
+            return Mix(utility::Weighted<Vector>(weight, vector, rest...));
         }
 
         Vector& operator*=(double rhs) // compound assignment (does not need to be a member,
@@ -141,6 +141,29 @@ namespace acrion::image
         }
 
     private:
+        template <typename Iterator>
+        Vector MixRange(const Iterator begin, const Iterator end) const
+        {
+            double sumW  = 0;
+            double sumVx = 0;
+            double sumVy = 0;
+
+            for (Iterator current = begin; current != end; ++current)
+            {
+                const double  weight = std::get<0>(*current);
+                const Vector& vector = std::get<1>(*current);
+                sumW += weight;
+                sumVx += weight * vector.Vx();
+                sumVy += weight * vector.Vy();
+            }
+
+            const double weight = std::max(0.0, std::min(1.0, 1 - sumW));
+
+            return Vector(std::make_pair(
+                weight * Vx() + sumVx,
+                weight * Vy() + sumVy));
+        }
+
         static constexpr double   INVALID{std::numeric_limits<double>::min()};
         std::pair<double, double> _v{std::make_pair(INVALID, INVALID)};
         mutable double            _phi{INVALID};
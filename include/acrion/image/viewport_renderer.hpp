@@ -0,0 +1,299 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "change_tracker.hpp"
+#include "display_buffer_pool.hpp"
+#include "display_pyramid.hpp"
+#include "display_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace acrion::image
+{
+    /// Renders viewports of an image for pan and zoom. Display tiles are converted 1:1 from the pyramid level that
+    /// matches the zoom and cached by (level, tile position, display transform); a viewport is then composited from
+    /// the cached tiles by nearest neighbour lookup. Tiles are re-rendered only if the display values (gamma, layout,
+    /// colormap, range) or the dither setting changed or the image's ChangeTracker reports a change in their
+    /// footprint, so panning only converts newly exposed tiles. Scaling and row alignment do not affect the tiles.
+    /// The image must outlive the renderer.
+    template <typename T>
+    class ViewportRenderer
+    {
+    public:
+        static constexpr int tileSize = 256;
+
+        /// `maxTiles` limits the number of cached tiles (256 tiles of 256 x 256 BGRA pixels are 64 MB)
+        explicit ViewportRenderer(const BitmapData<T>& image, const size_t maxTiles = 256)
+            : _image(image)
+            , _pyramid(image, tileSize)
+            , _maxTiles(maxTiles)
+        {
+        }
+
+        /// Renders the image region starting at (x, y) with size (w, h), in image pixels, stretched to
+        /// outputWidth x outputHeight pixels of `destination`. The layout is that of
+        /// BitmapData::ConvertToDepth8; pixels outside the image are gray.
+        void Render(uint8_t* destination, const size_t destStride, const DisplayOptions& options, const double x, const double y, const double w, const double h, const int outputWidth, const int outputHeight)
+        {
+            if (outputWidth <= 0 || outputHeight <= 0)
+            {
+                return;
+            }
+
+            const auto   transform    = DisplayTransform<T>::Cached(options, _image.GetMinDisplayedBrightness(), _image.GetMaxDisplayedBrightness());
+            const size_t destChannels = transform->DestinationChannels(_image.Channels());
+
+            if (destStride < (size_t)outputWidth * destChannels)
+            {
+                throw std::runtime_error("acrion::image::ViewportRenderer::Render: stride " + std::to_string(destStride) + " is too small for " + std::to_string(outputWidth) + " pixels of " + std::to_string(destChannels) + " bytes");
+            }
+
+            std::lock_guard<std::mutex> lock(_mtx);
+
+            if (_image.Changes() != _tracker.get())
+            {
+                _tracker = _image.TrackChanges();
+                _tiles.clear();
+            }
+
+            ++_frame;
+
+            // Snapshot of the changes that this frame includes, taken before any pixel is read. Tiles rendered
+            // now are stamped with it, so changes whose marks complete later are rendered again next time.
+            const uint64_t epoch = _tracker->Epoch();
+
+            // the smallest level that still has at least the output resolution
+            const double scaleX = w / outputWidth;
+            const double scaleY = h / outputHeight;
+            int          level  = 0;
+            while (level < _pyramid.Levels() && std::ldexp(1.0, level + 1) <= std::min(scaleX, scaleY))
+            {
+                ++level;
+            }
+
+            const BitmapData<T>& source      = _pyramid.Level(level);
+            const double         factor      = std::ldexp(1.0, -level);
+            const int            levelWidth  = source.Width();
+            const int            levelHeight = source.Height();
+
+            // level coordinates of every output column and row; -1 if outside the level
+            std::vector<int> columns(outputWidth);
+            std::vector<int> rows(outputHeight);
+            for (int i = 0; i < outputWidth; ++i)
+            {
+                const int u = (int)std::floor((x + (i + 0.5) * scaleX) * factor);
+                columns[i]  = u >= 0 && u < levelWidth ? u : -1;
+            }
+            for (int j = 0; j < outputHeight; ++j)
+            {
+                const int v = (int)std::floor((y + (j + 0.5) * scaleY) * factor);
+                rows[j]     = v >= 0 && v < levelHeight ? v : -1;
+            }
+
+            // make sure every visible tile is cached and current
+            const int firstColumn = FirstVisible(columns);
+            const int firstRow    = FirstVisible(rows);
+            const int tx0         = firstColumn / tileSize;
+            const int tx1         = LastVisible(columns) / tileSize;
+            const int ty0         = firstRow / tileSize;
+            const int ty1         = LastVisible(rows) / tileSize;
+
+            std::vector<const Tile*> visible;
+            if (firstColumn >= 0 && firstRow >= 0)
+            {
+                visible.resize((size_t)(tx1 - tx0 + 1) * (ty1 - ty0 + 1));
+                for (int ty = ty0; ty <= ty1; ++ty)
+                {
+                    for (int tx = tx0; tx <= tx1; ++tx)
+                    {
+                        visible[(size_t)(ty - ty0) * (tx1 - tx0 + 1) + (tx - tx0)] = &Acquire(source, transform, level, tx, ty, epoch);
+                    }
+                }
+                Evict();
+            }
+
+#pragma omp parallel for
+            for (int j = 0; j < outputHeight; ++j)
+            {
+                uint8_t*  dest = destination + (size_t)j * destStride;
+                const int v    = rows[j];
+
+                if (v < 0 || visible.empty())
+                {
+                    std::memset(dest, 55, outputWidth * destChannels);
+                    continue;
+                }
+
+                const Tile* const* tileRow = visible.data() + (size_t)(v / tileSize - ty0) * (tx1 - tx0 + 1);
+                const size_t       tileY   = v % tileSize;
+
+                for (int i = 0; i < outputWidth; ++i, dest += destChannels)
+                {
+                    const int u = columns[i];
+
+                    if (u < 0)
+                    {
+                        std::memset(dest, 55, destChannels);
+                        continue;
+                    }
+
+                    const Tile* tile = tileRow[u / tileSize - tx0];
+                    std::memcpy(dest, tile->pixels.data() + tileY * tile->stride + (size_t)(u % tileSize) * destChannels, destChannels);
+                }
+            }
+        }
+
+        /// Like above, but renders into a buffer from `pool`.
+        DisplayBuffer Render(DisplayBufferPool& pool, const DisplayOptions& options, const double x, const double y, const double w, const double h, const int outputWidth, const int outputHeight)
+        {
+            const auto    transform = DisplayTransform<T>::Cached(options, _image.GetMinDisplayedBrightness(), _image.GetMaxDisplayedBrightness());
+            DisplayBuffer buffer    = pool.Acquire(outputWidth, outputHeight, transform->DestinationChannels(_image.Channels()), transform->Stride(_image.Channels(), outputWidth));
+            Render(buffer.Data(), buffer.Stride(), options, x, y, w, h, outputWidth, outputHeight);
+            return buffer;
+        }
+
+        /// number of tiles converted since construction, for profiling
+        size_t RenderedTiles() const
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            return _renderedTiles;
+        }
+
+        size_t CachedTiles() const
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            return _tiles.size();
+        }
+
+    private:
+        struct Tile
+        {
+            std::vector<uint8_t>                       pixels;
+            size_t                                     stride{0};
+            std::shared_ptr<const DisplayTransform<T>> transform;
+            uint64_t                                   epoch{0}; // tracker epoch the tile was rendered at
+            uint64_t                                   frame{0}; // last frame that used the tile
+        };
+
+        static int FirstVisible(const std::vector<int>& coordinates)
+        {
+            for (const int c : coordinates)
+            {
+                if (c >= 0)
+                {
+                    return c;
+                }
+            }
+            return -1;
+        }
+
+        static int LastVisible(const std::vector<int>& coordinates)
+        {
+            for (auto it = coordinates.rbegin(); it != coordinates.rend(); ++it)
+            {
+                if (*it >= 0)
+                {
+                    return *it;
+                }
+            }
+            return -1;
+        }
+
+        static uint64_t Key(const int level, const int tx, const int ty)
+        {
+            return ((uint64_t)level << 56) | ((uint64_t)(uint32_t)tx << 28) | (uint64_t)(uint32_t)ty;
+        }
+
+        const Tile& Acquire(const BitmapData<T>& source, const std::shared_ptr<const DisplayTransform<T>>& transform, const int level, const int tx, const int ty, const uint64_t epoch)
+        {
+            const int x = tx * tileSize;
+            const int y = ty * tileSize;
+            const int w = std::min(tileSize, source.Width() - x);
+            const int h = std::min(tileSize, source.Height() - y);
+
+            Tile&      tile  = _tiles[Key(level, tx, ty)];
+            const int  scale = 1 << level; // footprint of a level pixel in image pixels
+            const bool stale = !tile.transform
+                            || !tile.transform->Matches(transform->Options(), transform->Min(), transform->Max())
+                            || tile.transform->Options().dither != transform->Options().dither
+                            || _tracker->ChangedSince(tile.epoch, x * scale, y * scale, w * scale, h * scale);
+
+            tile.frame = _frame;
+
+            if (stale)
+            {
+                tile.epoch     = epoch;
+                tile.transform = transform;
+                tile.stride    = (size_t)w * transform->DestinationChannels(source.Channels());
+                tile.pixels.resize(tile.stride * h);
+                source.ConvertToDepth8(tile.pixels.data(), tile.stride, *transform, x, y, w, h);
+                ++_renderedTiles;
+            }
+
+            return tile;
+        }
+
+        void Evict()
+        {
+            while (_tiles.size() > _maxTiles)
+            {
+                auto oldest = _tiles.end();
+                for (auto it = _tiles.begin(); it != _tiles.end(); ++it)
+                {
+                    if (it->second.frame != _frame && (oldest == _tiles.end() || it->second.frame < oldest->second.frame))
+                    {
+                        oldest = it;
+                    }
+                }
+
+                if (oldest == _tiles.end())
+                {
+                    return; // everything is visible
+                }
+
+                _tiles.erase(oldest);
+            }
+        }
+
+        const BitmapData<T>&                 _image;
+        DisplayPyramid<T>                    _pyramid;
+        size_t                               _maxTiles;
+        std::shared_ptr<const ChangeTracker> _tracker;
+        std::unordered_map<uint64_t, Tile>   _tiles;
+        uint64_t                             _frame{0};
+        size_t                               _renderedTiles{0};
+        mutable std::mutex                   _mtx;
+    };
+}
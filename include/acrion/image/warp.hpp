@@ -0,0 +1,419 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of acrion image, see https://github.com/acrion/image
+
+acrion image is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+acrion image is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+acrion image is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with acrion image. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "bitmap_data.hpp"
+#include "interpolation.hpp"
+#include "resampling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace acrion::image
+{
+    /// Maps destination pixel (x, y) to the source position (m[0] x + m[1] y + m[2], m[3] x + m[4] y + m[5]).
+    /// Pixel centres are at integer coordinates, as for BitmapData::Get(double, double).
+    using AffineMatrix = std::array<double, 6>;
+
+    /// Maps destination pixel (x, y) to the source position (u / w, v / w) with u = m[0] x + m[1] y + m[2],
+    /// v = m[3] x + m[4] y + m[5] and w = m[6] x + m[7] y + m[8]. Positions with w <= 0 lie outside the source.
+    using PerspectiveMatrix = std::array<double, 9>;
+
+    enum class WarpFilter
+    {
+        Nearest,
+        Bilinear,
+        Bicubic,            // Keys cubic convolution (a = -0.5) over 4 x 4 source pixels
+        EdgeAware,          // the library's eight-neighbour interpolation, see interpolation::Do
+        EdgeAwareTabulated, // the same with tabulated weights, see interpolation::DoTabulated
+    };
+
+    struct WarpOptions
+    {
+        WarpFilter filter{WarpFilter::Bilinear};
+        double     fill{0}; // value of all channels of destination pixels that map outside the source
+    };
+
+    /// Inverts an affine matrix, e.g. to turn a source-to-destination transform into the one Warp expects.
+    inline AffineMatrix Invert(const AffineMatrix& m)
+    {
+        const double det = m[0] * m[4] - m[1] * m[3];
+        if (det == 0)
+        {
+            throw std::runtime_error("acrion::image::Invert: affine matrix is singular");
+        }
+
+        const double a = m[4] / det;
+        const double b = -m[1] / det;
+        const double d = -m[3] / det;
+        const double e = m[0] / det;
+        return {a, b, -(a * m[2] + b * m[5]), d, e, -(d * m[2] + e * m[5])};
+    }
+
+    inline PerspectiveMatrix Invert(const PerspectiveMatrix& m)
+    {
+        const PerspectiveMatrix adjugate = {m[4] * m[8] - m[5] * m[7], m[2] * m[7] - m[1] * m[8], m[1] * m[5] - m[2] * m[4],
+                                            m[5] * m[6] - m[3] * m[8], m[0] * m[8] - m[2] * m[6], m[2] * m[3] - m[0] * m[5],
+                                            m[3] * m[7] - m[4] * m[6], m[1] * m[6] - m[0] * m[7], m[0] * m[4] - m[1] * m[3]};
+
+        const double det = m[0] * adjugate[0] + m[1] * adjugate[3] + m[2] * adjugate[6];
+        if (det == 0)
+        {
+            throw std::runtime_error("acrion::image::Invert: perspective matrix is singular");
+        }
+
+        PerspectiveMatrix result;
+        for (int k = 0; k < 9; ++k)
+        {
+            result[k] = adjugate[k] / det;
+        }
+        return result;
+    }
+
+    namespace detail
+    {
+        constexpr int warpTileSize = 64;
+
+        /// Source positions along a destination row of an affine warp, advanced by one addition per pixel.
+        struct AffineRow
+        {
+            double sx;
+            double sy;
+            double stepX;
+            double stepY;
+
+            AffineRow(const AffineMatrix& m, const int x, const int y)
+                : sx(m[0] * x + m[1] * y + m[2])
+                , sy(m[3] * x + m[4] * y + m[5])
+                , stepX(m[0])
+                , stepY(m[3])
+            {
+            }
+
+            /// the current position; returns false if it has no source position
+            bool Get(double& x, double& y) const
+            {
+                x = sx;
+                y = sy;
+                return true;
+            }
+
+            void Next()
+            {
+                sx += stepX;
+                sy += stepY;
+            }
+        };
+
+        /// Same for a perspective warp: the homogeneous coordinates advance incrementally, one division per pixel.
+        struct PerspectiveRow
+        {
+            double u;
+            double v;
+            double w;
+            double stepU;
+            double stepV;
+            double stepW;
+
+            PerspectiveRow(const PerspectiveMatrix& m, const int x, const int y)
+                : u(m[0] * x + m[1] * y + m[2])
+                , v(m[3] * x + m[4] * y + m[5])
+                , w(m[6] * x + m[7] * y + m[8])
+                , stepU(m[0])
+                , stepV(m[3])
+                , stepW(m[6])
+            {
+            }
+
+            bool Get(double& x, double& y) const
+            {
+                if (w <= 0)
+                {
+                    return false;
+                }
+                x = u / w;
+                y = v / w;
+                return true;
+            }
+
+            void Next()
+            {
+                u += stepU;
+                v += stepV;
+                w += stepW;
+            }
+        };
+
+        /// Source positions from which every tap of `filter` lies inside the image are in [lower, size - upper).
+        constexpr double WarpLowerMargin(const WarpFilter filter)
+        {
+            return filter == WarpFilter::Bilinear ? 0.0 : filter == WarpFilter::Bicubic ? 1.0 : -0.5;
+        }
+
+        constexpr double WarpUpperMargin(const WarpFilter filter)
+        {
+            return filter == WarpFilter::Bilinear ? 1.0 : filter == WarpFilter::Bicubic ? 2.0 : 0.5;
+        }
+
+        /// Writes the sample of `source` at (sx, sy) to `out`. Unless `inside`, the position may lie anywhere: taps
+        /// beyond the border repeat the border pixels, and positions outside the source get `fill`.
+        template <WarpFilter filter, bool inside, typename T>
+        inline void WarpSample(const BitmapData<T>& source, const double sx, const double sy, T* out, const T fill)
+        {
+            const int channels = source.Channels();
+            const int width    = source.Width();
+            const int height   = source.Height();
+
+            if constexpr (!inside)
+            {
+                if (!(sx >= -0.5 && sx < width - 0.5 && sy >= -0.5 && sy < height - 0.5))
+                {
+                    std::fill(out, out + channels, fill);
+                    return;
+                }
+            }
+
+            const auto column = [width](const int x)
+            {
+                return inside ? x : std::min(width - 1, std::max(0, x));
+            };
+            const auto row = [&source, height, width, channels](const int y)
+            {
+                return source.Buffer() + (size_t)(inside ? y : std::min(height - 1, std::max(0, y))) * width * channels;
+            };
+
+            if constexpr (filter == WarpFilter::Nearest)
+            {
+                const T* p = row((int)std::floor(sy + 0.5)) + (size_t)column((int)std::floor(sx + 0.5)) * channels;
+                std::copy(p, p + channels, out);
+            }
+            else if constexpr (filter == WarpFilter::Bilinear)
+            {
+                const int    ix  = (int)std::floor(sx);
+                const int    iy  = (int)std::floor(sy);
+                const double fx  = sx - ix;
+                const double fy  = sy - iy;
+                const T*     top = row(iy);
+                const T*     bot = row(iy + 1);
+                const size_t x0  = (size_t)column(ix) * channels;
+                const size_t x1  = (size_t)column(ix + 1) * channels;
+
+                for (int c = 0; c < channels; ++c)
+                {
+                    const double upper = top[x0 + c] + fx * ((double)top[x1 + c] - top[x0 + c]);
+                    const double lower = bot[x0 + c] + fx * ((double)bot[x1 + c] - bot[x0 + c]);
+                    out[c]             = ToSample<T>(upper + fy * (lower - upper));
+                }
+            }
+            else if constexpr (filter == WarpFilter::Bicubic)
+            {
+                const int    ix = (int)std::floor(sx);
+                const int    iy = (int)std::floor(sy);
+                const double fx = sx - ix;
+                const double fy = sy - iy;
+
+                double       wx[4];
+                double       wy[4];
+                size_t       xs[4];
+                const T*     rows[4];
+                for (int k = 0; k < 4; ++k)
+                {
+                    wx[k]   = CubicKernel(fx - (k - 1));
+                    wy[k]   = CubicKernel(fy - (k - 1));
+                    xs[k]   = (size_t)column(ix + k - 1) * channels;
+                    rows[k] = row(iy + k - 1);
+                }
+
+                for (int c = 0; c < channels; ++c)
+                {
+                    double sum = 0;
+                    for (int j = 0; j < 4; ++j)
+                    {
+                        const T* r = rows[j] + c;
+                        sum += wy[j] * (wx[0] * r[xs[0]] + wx[1] * r[xs[1]] + wx[2] * r[xs[2]] + wx[3] * r[xs[3]]);
+                    }
+                    out[c] = ToSample<T>(sum);
+                }
+            }
+            else
+            {
+                constexpr interpolation::Mode mode = filter == WarpFilter::EdgeAwareTabulated ? interpolation::Mode::Tabulated : interpolation::Mode::Exact;
+
+                if (channels == 1)
+                {
+                    out[0] = source.GetGray(sx, sy, mode);
+                }
+                else
+                {
+                    const Color<T> color = source.Get(sx, sy, mode);
+                    const int      red   = channels == 4 ? 1 : 0;
+                    out[red]             = color.Red();
+                    out[red + 1]         = color.Green();
+                    out[red + 2]         = color.Blue();
+                    if (channels == 4)
+                    {
+                        out[0] = color.Alpha();
+                    }
+                }
+            }
+        }
+
+        /// Warps destination tile by tile. A tile whose corners all map to positions where every tap of the filter
+        /// lies inside the source is rendered without bounds checks; the mapped tile is convex, so its interior
+        /// is inside, too.
+        template <WarpFilter filter, typename T, typename Matrix, typename Row>
+        void Warp(const BitmapData<T>& source, BitmapData<T>& destination, const Matrix& matrix, const T fill)
+        {
+            const int channels = destination.Channels();
+            const int width    = destination.Width();
+            const int height   = destination.Height();
+            const int tilesX   = (width + warpTileSize - 1) / warpTileSize;
+            const int tilesY   = (height + warpTileSize - 1) / warpTileSize;
+
+            // the corners are computed directly, the pixels in between by incremental steps; the slack covers the
+            // difference in rounding
+            constexpr double slack = 1e-6;
+
+            const double minX = WarpLowerMargin(filter) + slack;
+            const double minY = WarpLowerMargin(filter) + slack;
+            const double maxX = source.Width() - WarpUpperMargin(filter) - slack;
+            const double maxY = source.Height() - WarpUpperMargin(filter) - slack;
+
+            const auto valid = [&](const int x, const int y)
+            {
+                double sx = 0, sy = 0;
+                return Row(matrix, x, y).Get(sx, sy) && sx >= minX && sx < maxX && sy >= minY && sy < maxY;
+            };
+
+#pragma omp parallel for schedule(dynamic)
+            for (int tile = 0; tile < tilesX * tilesY; ++tile)
+            {
+                const int x0 = (tile % tilesX) * warpTileSize;
+                const int y0 = (tile / tilesX) * warpTileSize;
+                const int x1 = std::min(width, x0 + warpTileSize);
+                const int y1 = std::min(height, y0 + warpTileSize);
+
+                const bool inside = valid(x0, y0) && valid(x1 - 1, y0) && valid(x0, y1 - 1) && valid(x1 - 1, y1 - 1);
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    T*  out = destination.Buffer() + ((size_t)y * width + x0) * channels;
+                    Row position(matrix, x0, y);
+
+                    for (int x = x0; x < x1; ++x, out += channels, position.Next())
+                    {
+                        double sx = 0, sy = 0;
+                        if (inside)
+                        {
+                            position.Get(sx, sy);
+                            WarpSample<filter, true>(source, sx, sy, out, fill);
+                        }
+                        else if (position.Get(sx, sy))
+                        {
+                            WarpSample<filter, false>(source, sx, sy, out, fill);
+                        }
+                        else
+                        {
+                            std::fill(out, out + channels, fill);
+                        }
+                    }
+                }
+            }
+        }
+
+        template <typename T, typename Matrix, typename Row>
+        void Warp(const BitmapData<T>& source, BitmapData<T>& destination, const Matrix& matrix, const WarpOptions& options)
+        {
+            if (source.Channels() != destination.Channels())
+            {
+                throw std::runtime_error("acrion::image::Warp: source has " + std::to_string(source.Channels()) + " channels, destination " + std::to_string(destination.Channels()));
+            }
+
+            if (source.Width() <= 0 || source.Height() <= 0)
+            {
+                throw std::runtime_error("acrion::image::Warp: source image is empty");
+            }
+
+            const T fill = ToSample<T>(options.fill);
+
+            switch (options.filter)
+            {
+            case WarpFilter::Nearest:
+                Warp<WarpFilter::Nearest, T, Matrix, Row>(source, destination, matrix, fill);
+                break;
+            case WarpFilter::Bilinear:
+                Warp<WarpFilter::Bilinear, T, Matrix, Row>(source, destination, matrix, fill);
+                break;
+            case WarpFilter::Bicubic:
+                Warp<WarpFilter::Bicubic, T, Matrix, Row>(source, destination, matrix, fill);
+                break;
+            case WarpFilter::EdgeAware:
+                Warp<WarpFilter::EdgeAware, T, Matrix, Row>(source, destination, matrix, fill);
+                break;
+            case WarpFilter::EdgeAwareTabulated:
+                Warp<WarpFilter::EdgeAwareTabulated, T, Matrix, Row>(source, destination, matrix, fill);
+                break;
+            }
+
+            destination.SetBrightnessRangeForDisplay(source.GetMinDisplayedBrightness(), source.GetMaxDisplayedBrightness());
+            destination.Invalidate();
+        }
+    }
+
+    /// Fills `destination` with `source` sampled at the positions `destinationToSource` maps each destination pixel
+    /// to. Both images must have the same number of channels.
+    template <typename T>
+    void WarpAffine(const BitmapData<T>& source, BitmapData<T>& destination, const AffineMatrix& destinationToSource, const WarpOptions& options = {})
+    {
+        detail::Warp<T, AffineMatrix, detail::AffineRow>(source, destination, destinationToSource, options);
+    }
+
+    template <typename T>
+    BitmapData<T> WarpAffine(const BitmapData<T>& source, const AffineMatrix& destinationToSource, const int width, const int height, const WarpOptions& options = {})
+    {
+        BitmapData<T> destination(width, height, source.Channels());
+        WarpAffine(source, destination, destinationToSource, options);
+        return destination;
+    }
+
+    template <typename T>
+    void WarpPerspective(const BitmapData<T>& source, BitmapData<T>& destination, const PerspectiveMatrix& destinationToSource, const WarpOptions& options = {})
+    {
+        detail::Warp<T, PerspectiveMatrix, detail::PerspectiveRow>(source, destination, destinationToSource, options);
+    }
+
+    template <typename T>
+    BitmapData<T> WarpPerspective(const BitmapData<T>& source, const PerspectiveMatrix& destinationToSource, const int width, const int height, const WarpOptions& options = {})
+    {
+        BitmapData<T> destination(width, height, source.Channels());
+        WarpPerspective(source, destination, destinationToSource, options);
+        return destination;
+    }
+}
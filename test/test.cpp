@@ -25,7 +25,27 @@ along with acrion image. If not, see <https://www.gnu.org/licenses/>.
 
 #include <gtest/gtest.h>
 
+#include "acrion/image/binning.hpp"
+#include "acrion/image/bitmap.hpp"
+#include "acrion/image/channel_conversion.hpp"
 #include "acrion/image/color.hpp"
+#include "acrion/image/colormap.hpp"
+#include "acrion/image/compositing.hpp"
+#include "acrion/image/display_pyramid.hpp"
+#include "acrion/image/interpolation.hpp"
+#include "acrion/image/luminance.hpp"
+#include "acrion/image/lut.hpp"
+#include "acrion/image/orientation.hpp"
+#include "acrion/image/remap.hpp"
+#include "acrion/image/resize.hpp"
+#include "acrion/image/rotate.hpp"
+#include "acrion/image/vector.hpp"
+#include "acrion/image/viewport_renderer.hpp"
+#include "acrion/image/warp.hpp"
+
+#include <array>
+#include <atomic>
+#include <thread>
 
 using namespace acrion::image;
 
@@ -58,3 +78,1112 @@ TEST(ImageFrameworkTest, WithBrightnessPlausible)
     EXPECT_LT(col1b.Green(), col1.Green());
     EXPECT_LT(col1b.Blue(), col1.Blue());
 }
+
+TEST(ImageFrameworkTest, ConvertDepthRoundTrip)
+{
+    BitmapData<uint16_t> image(5, 3, 3);
+    for (int i = 0; i < image.Width() * image.Height() * image.Channels(); ++i)
+    {
+        image.Buffer()[i] = (uint16_t)(i * 4099);
+    }
+
+    const auto asDouble = ConvertDepth<double>(image);
+    const auto back     = ConvertDepth<uint16_t>(asDouble);
+    EXPECT_EQ(std::memcmp(back.Buffer(), image.Buffer(), image.Size()), 0);
+
+    const auto depth8 = ConvertDepth<uint8_t>(image, DepthConversion::FullRange<uint16_t, uint8_t>());
+    EXPECT_EQ(depth8.Buffer()[1], (uint8_t)std::lround(4099 * 255.0 / 65535));
+    EXPECT_EQ(depth8.GetMaxDisplayedBrightness(), 255);
+
+    const Bitmap saturated = Bitmap(image).ConvertDepth(1);
+    EXPECT_EQ(saturated.Depth(), 1);
+    EXPECT_EQ(((const uint8_t*)saturated.Buffer())[0], 0);
+    EXPECT_EQ(((const uint8_t*)saturated.Buffer())[1], 255);
+
+    // NaN converts to 0 with every rounding, saturated or not
+    BitmapData<double> undefined(2, 1, 1);
+    undefined.Buffer()[0] = std::numeric_limits<double>::quiet_NaN();
+    undefined.Buffer()[1] = 7.6;
+    for (const Rounding rounding : {Rounding::Nearest, Rounding::Down, Rounding::TowardZero})
+    {
+        for (const bool saturate : {true, false})
+        {
+            DepthConversion conversion;
+            conversion.rounding = rounding;
+            conversion.saturate = saturate;
+
+            const auto converted = ConvertDepth<uint16_t>(undefined, conversion);
+            EXPECT_EQ(converted.Buffer()[0], 0);
+            EXPECT_EQ(converted.Buffer()[1], rounding == Rounding::Nearest ? 8 : 7);
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, ChannelConversion)
+{
+    BitmapData<uint16_t> argb(7, 2, 4);
+    for (int i = 0; i < argb.Width() * argb.Height() * 4; ++i)
+    {
+        argb.Buffer()[i] = (uint16_t)(i * 7919);
+    }
+
+    const auto gray = ConvertChannels(argb, 1);
+    const auto rgb  = ConvertChannels(argb, 3);
+    for (int y = 0; y < argb.Height(); ++y)
+    {
+        for (int x = 0; x < argb.Width(); ++x)
+        {
+            EXPECT_NEAR(gray.GetGray(x, y), argb.Get(x, y).Gray(), 1);
+            EXPECT_EQ(rgb.GetRed(x, y), argb.GetRed(x, y));
+            EXPECT_EQ(rgb.GetBlue(x, y), argb.GetBlue(x, y));
+        }
+    }
+
+    const auto broadcast = ConvertChannels(gray, 4);
+    EXPECT_EQ(broadcast.Get(3, 1), Color<uint16_t>(gray.GetGray(3, 1)));
+    EXPECT_EQ(ConvertChannels(broadcast, 1).GetGray(3, 1), gray.GetGray(3, 1));
+
+    std::vector<uint16_t> bgra(argb.Width() * argb.Height() * 4);
+    SwizzleArgbToBgra(argb, bgra.data());
+    EXPECT_EQ(bgra[0], argb.GetBlue(0, 0));
+    EXPECT_EQ(bgra[3], argb.GetAlpha(0, 0));
+
+    // 32 bit samples near the top of their range
+    BitmapData<uint32_t> rgb32(5, 3, 3);
+    for (int i = 0; i < 5 * 3 * 3; ++i)
+    {
+        rgb32.Buffer()[i] = 4294967295u - (uint32_t)(i * 2654435761u % 400000000u);
+    }
+
+    const auto gray32 = ConvertChannels(rgb32, 1);
+    for (int y = 0; y < 3; ++y)
+    {
+        for (int x = 0; x < 5; ++x)
+        {
+            EXPECT_NEAR((double)gray32.GetGray(x, y), (double)rgb32.Get(x, y).Gray(), 1);
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, RemapLuminanceMatchesWithBrightness)
+{
+    BitmapData<uint8_t> image(16, 16, 4);
+    for (int y = 0; y < image.Height(); ++y)
+    {
+        for (int x = 0; x < image.Width(); ++x)
+        {
+            image.Plot(x, y, Color<uint8_t>((uint8_t)(x * 16), (uint8_t)(y * 16), (uint8_t)(x * y), (uint8_t)(x + y)));
+        }
+    }
+
+    const BitmapData<uint8_t> original(image);
+    auto                      darker = [](uint8_t luma) { return (uint8_t)(luma * 3 / 4); };
+    RemapLuminance(image, darker, 0, 0, 0, 8);
+
+    for (int y = 0; y < image.Height(); ++y)
+    {
+        for (int x = 0; x < image.Width(); ++x)
+        {
+            const Color<uint8_t> before   = original.Get(x, y);
+            const Color<uint8_t> after    = image.Get(x, y);
+            const Color<uint8_t> expected = y < 8 ? before.WithBrightness(darker(before.Gray())) : before;
+            EXPECT_NEAR(after.Red(), expected.Red(), 2);
+            EXPECT_NEAR(after.Green(), expected.Green(), 2);
+            EXPECT_NEAR(after.Blue(), expected.Blue(), 2);
+            EXPECT_EQ(after.Alpha(), before.Alpha());
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, CompositeOver)
+{
+    BitmapData<uint8_t> frame(4, 4, 4);
+    frame.Set(Color<uint8_t>(200, 100, 0));
+
+    BitmapData<uint8_t> layer(2, 2, 4);
+    layer.Set(Color<uint8_t>(0, 0, 255, 128));
+    Premultiply(layer);
+    EXPECT_EQ(layer.Get(0, 0), Color<uint8_t>(0, 0, 128, 128));
+
+    Composite(frame, layer, 3, 3);
+    EXPECT_EQ(frame.Get(2, 2), Color<uint8_t>(200, 100, 0));
+    EXPECT_EQ(frame.Get(3, 3), Color<uint8_t>(100, 50, 128, 255));
+
+    Composite(frame, layer, 0, 0, CompositeOperation::In);
+    EXPECT_EQ(frame.Get(0, 0), Color<uint8_t>(0, 0, 128, 128));
+
+    Unpremultiply(frame);
+    EXPECT_EQ(frame.Get(0, 0), Color<uint8_t>(0, 0, 255, 128));
+
+    // floating point alpha is in [0, 1]
+    BitmapData<double> frameD(2, 2, 4);
+    frameD.Set(Color<double>(0.8, 0.4, 0.0, 1.0));
+    BitmapData<double> layerD(2, 2, 4);
+    layerD.Set(Color<double>(0.0, 0.0, 1.0, 0.5));
+    Premultiply(layerD);
+    EXPECT_DOUBLE_EQ(layerD.Get(0, 0).Blue(), 0.5);
+
+    Composite(frameD, layerD, 0, 0);
+    EXPECT_DOUBLE_EQ(frameD.Get(1, 1).Red(), 0.4);
+    EXPECT_DOUBLE_EQ(frameD.Get(1, 1).Blue(), 0.5);
+    EXPECT_DOUBLE_EQ(frameD.Get(1, 1).Alpha(), 1.0);
+
+    Unpremultiply(layerD);
+    EXPECT_DOUBLE_EQ(layerD.Get(0, 0).Blue(), 1.0);
+}
+
+TEST(ImageFrameworkTest, MulNormalizedExact16)
+{
+    for (uint32_t a = 0; a < 65536; a += 257)
+    {
+        for (uint32_t b = 0; b < 65536; b += 1021)
+        {
+            EXPECT_EQ(detail::MulNormalized((uint16_t)a, (uint16_t)b), (uint16_t)std::lround(a * (double)b / 65535));
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, ApplyLut)
+{
+    BitmapData<uint16_t> image(3, 2, 3);
+    for (int i = 0; i < image.Width() * image.Height() * 3; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)(i * 1000);
+    }
+
+    const auto invert = MakeLut<uint16_t, uint16_t>([](uint16_t v) { return 65535 - v; });
+    ApplyLut(image, image, invert);
+    EXPECT_EQ(image.GetRed(0, 0), 65535);
+    EXPECT_EQ(image.GetGreen(0, 0), 64535);
+
+    const auto scaled = ApplyLut(image, MakeLut<uint16_t, double>([](uint16_t v) { return v / 65535.0; }));
+    EXPECT_DOUBLE_EQ(scaled.GetBlue(2, 1), image.GetBlue(2, 1) / 65535.0);
+
+    const std::vector<std::vector<uint8_t>> perChannel{MakeLut<uint16_t, uint8_t>([](uint16_t) { return 1; }),
+                                                       MakeLut<uint16_t, uint8_t>([](uint16_t) { return 2; }),
+                                                       MakeLut<uint16_t, uint8_t>([](uint16_t) { return 3; })};
+    EXPECT_EQ(ApplyLut(image, perChannel).Get(1, 1), Color<uint8_t>(1, 2, 3));
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8TableMatchesDirectMapping)
+{
+    BitmapData<uint16_t> image(256, 256, 1);
+    for (int i = 0; i < 65536; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)i;
+    }
+    image.SetBrightnessRangeForDisplay(1000, 50000);
+
+    for (const double gamma : {0.0, 0.5})
+    {
+        DisplayOptions options;
+        options.gamma = gamma;
+
+        const auto                 transform = DisplayTransform<uint16_t>::Cached(options, 1000, 50000);
+        std::unique_ptr<uint8_t[]> full(image.ConvertToDepth8(gamma));
+
+        int mismatches = 0;
+        for (int i = 0; i < 65536; ++i)
+        {
+            mismatches += full[i] != transform->Mapping()((uint16_t)i);
+        }
+        EXPECT_EQ(mismatches, 0);
+    }
+
+    std::unique_ptr<uint8_t[]> linear(image.ConvertToDepth8(0.0));
+    EXPECT_EQ(linear[0], 0);
+    EXPECT_EQ(linear[25500], std::lround(255.0 * 24500 / 49000));
+    EXPECT_EQ(linear[60000], 255);
+}
+
+TEST(ImageFrameworkTest, DisplayTransformSharedBetweenThreads)
+{
+    BitmapData<uint16_t> image(64, 64, 3);
+    for (int i = 0; i < 64 * 64 * 3; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)(i * 13);
+    }
+    image.SetBrightnessRangeForDisplay(0, 65535);
+
+    DisplayOptions linear;
+    DisplayOptions logarithmic;
+    logarithmic.gamma = 0.8;
+
+    EXPECT_EQ(DisplayTransform<uint16_t>::Cached(linear, 0, 65535), DisplayTransform<uint16_t>::Cached(linear, 0, 65535));
+
+    // options that only change how a call renders share the tables
+    DisplayOptions scaled = linear;
+    scaled.scaling        = ResampleFilter::Bilinear;
+    scaled.dither         = true;
+    scaled.rowAlignment   = 16;
+    const auto shared     = DisplayTransform<uint16_t>::Cached(scaled, 0, 65535);
+    EXPECT_EQ(shared->Table(), DisplayTransform<uint16_t>::Cached(linear, 0, 65535)->Table());
+    EXPECT_EQ(shared->Options(), scaled);
+
+    std::unique_ptr<uint8_t[]> expectedLinear(image.ConvertToDepth8(linear));
+    std::unique_ptr<uint8_t[]> expectedLogarithmic(image.ConvertToDepth8(logarithmic));
+
+    std::vector<std::thread> threads;
+    std::atomic<int>         mismatches{0};
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            const bool                 odd = t % 2 != 0;
+            std::unique_ptr<uint8_t[]> result(image.ConvertToDepth8(odd ? logarithmic : linear));
+            const uint8_t*             expected = odd ? expectedLogarithmic.get() : expectedLinear.get();
+            mismatches += std::memcmp(result.get(), expected, 64 * 64 * 4) != 0;
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+
+    DisplayOptions gray8;
+    gray8.layout = DisplayLayout::Gray8;
+    std::unique_ptr<uint8_t[]> gray(image.ConvertToDepth8(gray8));
+    const uint8_t*             bgra = expectedLinear.get();
+    EXPECT_EQ(gray[0], (uint8_t)((detail::grayWeightRed * bgra[2] + detail::grayWeightGreen * bgra[1] + detail::grayWeightBlue * bgra[0] + 32768) >> 16));
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8IntoReusedBuffers)
+{
+    BitmapData<uint8_t> image(30, 20, 1);
+    for (int i = 0; i < 30 * 20; ++i)
+    {
+        image.Buffer()[i] = (uint8_t)i;
+    }
+    image.SetBrightnessRangeForDisplay(0, 255);
+
+    std::unique_ptr<uint8_t[]> expected(image.ConvertToDepth8(0.0)); // gray rows are padded to 32 bytes
+
+    std::vector<uint8_t> strided(40 * 20, 0xAB);
+    image.ConvertToDepth8(strided.data(), 40, DisplayOptions{});
+    for (int y = 0; y < 20; ++y)
+    {
+        EXPECT_EQ(std::memcmp(strided.data() + y * 40, expected.get() + y * 32, 30), 0);
+        EXPECT_EQ(strided[y * 40 + 35], 0xAB);
+    }
+    EXPECT_THROW(image.ConvertToDepth8(strided.data(), 29, DisplayOptions{}), std::runtime_error);
+
+    DisplayBufferPool pool;
+    const uint8_t*    first = nullptr;
+    {
+        DisplayBuffer buffer = image.ConvertToDepth8(pool);
+        first                = buffer.Data();
+        EXPECT_EQ(buffer.Stride(), 32u);
+        EXPECT_EQ(std::memcmp(buffer.Data() + 19 * 32, expected.get() + 19 * 32, 30), 0);
+    }
+    EXPECT_EQ(pool.IdleBuffers(), 1u);
+
+    DisplayBuffer again = image.ConvertToDepth8(pool);
+    EXPECT_EQ(again.Data(), first);
+    EXPECT_EQ(pool.IdleBuffers(), 0u);
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8FilteredDownscale)
+{
+    BitmapData<uint8_t> checkerboard(8, 8, 1);
+    for (int y = 0; y < 8; ++y)
+    {
+        for (int x = 0; x < 8; ++x)
+        {
+            checkerboard.Buffer()[y * 8 + x] = (x + y) % 2 == 0 ? 0 : 255;
+        }
+    }
+    checkerboard.SetBrightnessRangeForDisplay(0, 255);
+
+    for (const ResampleFilter filter : {ResampleFilter::Box, ResampleFilter::Area, ResampleFilter::Bilinear})
+    {
+        DisplayOptions options;
+        options.scaling = filter;
+
+        std::unique_ptr<uint8_t[]> reduced(checkerboard.ConvertToDepth8(options, 0, 0, 8, 8, 4, 4));
+        for (int i = 0; i < 16; ++i)
+        {
+            EXPECT_EQ(reduced[i], 128) << "filter " << (int)filter << ", pixel " << i;
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> nearest(checkerboard.ConvertToDepth8(0.0, 0, 0, 8, 8, 4, 4));
+    EXPECT_EQ(nearest[0], 0);
+}
+
+TEST(ImageFrameworkTest, DisplayPyramidFollowsChanges)
+{
+    BitmapData<uint16_t> image(256, 256, 1);
+    for (int y = 0; y < 256; ++y)
+    {
+        for (int x = 0; x < 256; ++x)
+        {
+            image.Buffer()[y * 256 + x] = (uint16_t)(x * 200 + y * 50);
+        }
+    }
+    image.SetBrightnessRangeForDisplay(0, 65535);
+
+    DisplayPyramid<uint16_t> pyramid(image, 32);
+    EXPECT_EQ(pyramid.Levels(), 3);
+
+    DisplayOptions area;
+    area.scaling = ResampleFilter::Area;
+
+    std::unique_ptr<uint8_t[]> direct(image.ConvertToDepth8(area, 0, 0, 256, 256, 64, 64));
+    std::unique_ptr<uint8_t[]> fromLevel(pyramid.ConvertToDepth8(area, 0, 0, 256, 256, 64, 64));
+    int                        maxDiff = 0;
+    for (int i = 0; i < 64 * 64; ++i)
+    {
+        maxDiff = std::max(maxDiff, std::abs(direct[i] - fromLevel[i]));
+    }
+    EXPECT_LE(maxDiff, 1);
+
+    for (int y = 100; y < 104; ++y)
+    {
+        for (int x = 200; x < 204; ++x)
+        {
+            image.Plot(x, y, Color<uint16_t>(65535));
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> updated(pyramid.ConvertToDepth8(area, 0, 0, 256, 256, 64, 64));
+    EXPECT_EQ(updated[25 * 64 + 50], 255);
+    EXPECT_EQ(updated[0], fromLevel[0]);
+    EXPECT_EQ(pyramid.Level(2).Get(50, 25).Gray(), 65535);
+
+    // viewers of one pyramid convert concurrently
+    std::vector<std::thread> viewers;
+    std::atomic<int>         mismatches{0};
+    for (int t = 0; t < 4; ++t)
+    {
+        viewers.emplace_back([&]()
+        {
+            std::vector<uint8_t> view(64 * 64);
+            pyramid.ConvertToDepth8(view.data(), 64, area, 0, 0, 256, 256, 64, 64);
+            mismatches += std::memcmp(view.data(), updated.get(), view.size()) != 0;
+        });
+    }
+    for (auto& viewer : viewers)
+    {
+        viewer.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(ImageFrameworkTest, ChangeTrackerConcurrentWriter)
+{
+    // A reader mirrors the image like a display cache: it snapshots the epoch, copies the changed tiles and
+    // remembers the snapshot, while a writer keeps changing the image. After the writer stops, one more
+    // synchronisation must bring the copy up to date; a change that was skipped for good would leave it stale.
+    BitmapData<uint32_t>                       image(128, 64, 1);
+    const std::shared_ptr<const ChangeTracker> tracker = image.TrackChanges();
+    std::vector<uint32_t>                      copy(128 * 64, 0);
+    uint64_t                                   synchronised = 0;
+
+    const auto synchronise = [&]
+    {
+        const uint64_t epoch = tracker->Epoch();
+        for (int ty = 0; ty < tracker->TilesY(); ++ty)
+        {
+            for (int tx = 0; tx < tracker->TilesX(); ++tx)
+            {
+                if (tracker->TileChangedSince(tx, ty, synchronised))
+                {
+                    for (int y = ty * ChangeTracker::tileSize; y < (ty + 1) * ChangeTracker::tileSize; ++y)
+                    {
+                        const size_t offset = (size_t)y * 128 + tx * ChangeTracker::tileSize;
+                        std::copy(image.Buffer() + offset, image.Buffer() + offset + ChangeTracker::tileSize, copy.data() + offset);
+                    }
+                }
+            }
+        }
+        synchronised = epoch;
+    };
+
+    std::atomic<bool> done{false};
+    std::thread       reader([&]
+                       {
+                           while (!done)
+                           {
+                               synchronise();
+                           }
+                       });
+
+    for (uint32_t k = 1; k <= 200000; ++k)
+    {
+        const int x = (int)(k % 2) * 64;
+        image.Buffer()[x] = k;
+        image.Invalidate(x, 0, 1, 1);
+    }
+
+    done = true;
+    reader.join();
+
+    synchronise();
+    EXPECT_EQ(copy[0], 200000u);
+    EXPECT_EQ(copy[64], 199999u);
+
+    // a line is marked once; plots into tiles that no reader has synchronised with yet draw no new epoch
+    const uint64_t before = tracker->Epoch();
+    image.Draw(0, 10, 127, 40, Color<uint32_t>(7));
+    EXPECT_EQ(tracker->Epoch(), before + 1);
+    EXPECT_TRUE(tracker->ChangedSince(before, 100, 35, 1, 1));
+    image.Plot(3, 3, Color<uint32_t>(8));
+    image.Plot(4, 3, Color<uint32_t>(8));
+    EXPECT_EQ(tracker->Epoch(), before + 2);
+    image.Plot(5, 3, Color<uint32_t>(8));
+    EXPECT_EQ(tracker->Epoch(), before + 3);
+
+    // untracked plots are marked by the caller, once for their region
+    image.Plot(6, 3, Color<uint32_t>(8), false);
+    image.Plot(7, 3, Color<uint32_t>(8), false);
+    EXPECT_EQ(tracker->Epoch(), before + 3);
+    image.Invalidate(6, 3, 2, 1);
+    EXPECT_EQ(tracker->Epoch(), before + 4);
+
+    // the same through a display pyramid, whose levels are updated concurrently
+    DisplayPyramid<uint32_t> pyramid(image, 16);
+    done = false;
+    std::thread updater([&]
+                        {
+                            while (!done)
+                            {
+                                pyramid.Update();
+                            }
+                        });
+
+    for (uint32_t k = 1; k <= 20000; ++k)
+    {
+        const int x = (int)(k * 7919 % 120);
+        const int y = (int)(k * 104729 % 56);
+        for (int j = y; j < y + 8; ++j)
+        {
+            std::fill(image.Buffer() + j * 128 + x, image.Buffer() + j * 128 + x + 8, k);
+        }
+        image.Invalidate(x, y, 8, 8);
+    }
+
+    done = true;
+    updater.join();
+
+    DisplayPyramid<uint32_t> fresh(image, 16);
+    for (int level = 1; level < pyramid.Levels(); ++level)
+    {
+        const BitmapData<uint32_t>& updated  = pyramid.Level(level);
+        const BitmapData<uint32_t>& expected = fresh.Level(level);
+        EXPECT_TRUE(std::equal(expected.Buffer(), expected.Buffer() + expected.Width() * expected.Height(), updated.Buffer())) << "level " << level;
+    }
+}
+
+TEST(ImageFrameworkTest, ViewportRendererReusesTiles)
+{
+    BitmapData<uint8_t> image(1024, 512, 1);
+    for (int i = 0; i < 1024 * 512; ++i)
+    {
+        image.Buffer()[i] = (uint8_t)(i * 7);
+    }
+    image.SetBrightnessRangeForDisplay(0, 255);
+
+    ViewportRenderer<uint8_t> renderer(image);
+    std::vector<uint8_t>      view(256 * 256);
+
+    renderer.Render(view.data(), 256, DisplayOptions{}, 0, 0, 256, 256, 256, 256);
+    EXPECT_EQ(renderer.RenderedTiles(), 1u);
+
+    renderer.Render(view.data(), 256, DisplayOptions{}, 128, 0, 256, 256, 256, 256);
+    EXPECT_EQ(renderer.RenderedTiles(), 2u); // only the newly exposed tile
+
+    std::vector<uint8_t> expected(256 * 256);
+    image.ConvertToDepth8(expected.data(), 256, DisplayOptions{}, 128, 0, 256, 256);
+    EXPECT_EQ(view, expected);
+
+    image.Plot(300, 10, Color<uint8_t>(0));
+    renderer.Render(view.data(), 256, DisplayOptions{}, 128, 0, 256, 256, 256, 256);
+    EXPECT_EQ(renderer.RenderedTiles(), 3u); // only the tile containing the changed pixel
+    EXPECT_EQ(view[10 * 256 + 172], 0);
+
+    renderer.Render(view.data(), 256, DisplayOptions{}, 0, 0, 1024, 512, 256, 128); // zoomed out: one tile of level 2
+    EXPECT_EQ(renderer.RenderedTiles(), 4u);
+
+    DisplayOptions aligned;
+    aligned.scaling      = ResampleFilter::Bilinear;
+    aligned.rowAlignment = 64;
+    renderer.Render(view.data(), 256, aligned, 0, 0, 1024, 512, 256, 128);
+    EXPECT_EQ(renderer.RenderedTiles(), 4u); // the tiles do not depend on scaling and alignment
+
+    EXPECT_NO_THROW(renderer.Render(view.data(), 0, DisplayOptions{}, 0, 0, 256, 256, -1, 256));
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8OrderedDither)
+{
+    BitmapData<uint16_t> flat(16, 16, 1);
+    BitmapData<double>   flatDouble(16, 16, 1);
+    for (int i = 0; i < 16 * 16; ++i)
+    {
+        flat.Buffer()[i]       = 2636; // 10.26 on the display scale
+        flatDouble.Buffer()[i] = 2636;
+    }
+    flat.SetBrightnessRangeForDisplay(0, 65535);
+    flatDouble.SetBrightnessRangeForDisplay(0, 65535);
+
+    DisplayOptions dithered;
+    dithered.dither = true;
+
+    std::unique_ptr<uint8_t[]> plain(flat.ConvertToDepth8(0.0));
+    std::unique_ptr<uint8_t[]> fromTable(flat.ConvertToDepth8(dithered));
+    std::unique_ptr<uint8_t[]> fromMapping(flatDouble.ConvertToDepth8(dithered));
+
+    int sum = 0;
+    for (int i = 0; i < 16 * 16; ++i)
+    {
+        EXPECT_EQ(plain[i], 10);
+        EXPECT_TRUE(fromTable[i] == 10 || fromTable[i] == 11);
+        EXPECT_EQ(fromTable[i], fromMapping[i]);
+        sum += fromTable[i];
+    }
+    EXPECT_NEAR(sum / 256.0, 255.0 * 2636 / 65535, 1.0 / 64);
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8Layouts)
+{
+    BitmapData<uint8_t> image(3, 2, 4);
+    image.Plot(1, 1, Color<uint8_t>(10, 20, 30, 40));
+    image.SetBrightnessRangeForDisplay(0, 255);
+
+    const auto pixel = [&image](const DisplayLayout layout, const int alignment, std::vector<uint8_t>& bytes)
+    {
+        DisplayOptions options;
+        options.layout       = layout;
+        options.rowAlignment = alignment;
+
+        const auto   transform = DisplayTransform<uint8_t>::Cached(options, 0, 255);
+        const size_t stride    = transform->Stride(image.Channels(), image.Width());
+        bytes.assign(stride * image.Height(), 0);
+        image.ConvertToDepth8(bytes.data(), stride, options);
+        return stride;
+    };
+
+    std::vector<uint8_t> bytes;
+    EXPECT_EQ(pixel(DisplayLayout::Rgba, 0, bytes), 12u);
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + 16, bytes.begin() + 20), (std::vector<uint8_t>{10, 20, 30, 40}));
+    EXPECT_EQ(pixel(DisplayLayout::Argb, 0, bytes), 12u);
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + 16, bytes.begin() + 20), (std::vector<uint8_t>{40, 10, 20, 30}));
+    EXPECT_EQ(pixel(DisplayLayout::Bgra, 16, bytes), 16u);
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + 20, bytes.begin() + 24), (std::vector<uint8_t>{30, 20, 10, 40}));
+    EXPECT_EQ(pixel(DisplayLayout::Rgb, 0, bytes), 12u); // 9 bytes padded to 4
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + 15, bytes.begin() + 18), (std::vector<uint8_t>{10, 20, 30}));
+    EXPECT_EQ(pixel(DisplayLayout::GrayAsBgra, 0, bytes), 12u);
+    const uint8_t luma = Color<uint8_t>(10, 20, 30).Gray();
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + 16, bytes.begin() + 20), (std::vector<uint8_t>{luma, luma, luma, 40}));
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8Colormap)
+{
+    BitmapData<uint16_t> image(4, 1, 1);
+    image.Buffer()[0] = 0;
+    image.Buffer()[1] = 1000;
+    image.Buffer()[2] = 2500;
+    image.Buffer()[3] = 4000;
+    image.SetBrightnessRangeForDisplay(1000, 3000);
+
+    std::array<Colormap::Rgb, 256> colors{};
+    for (int i = 0; i < 256; ++i)
+    {
+        colors[i] = {(uint8_t)i, (uint8_t)(255 - i), 7};
+    }
+
+    DisplayOptions options;
+    options.colormap = std::make_shared<const Colormap>(colors);
+
+    const auto transform = DisplayTransform<uint16_t>::Cached(options, 1000, 3000);
+    EXPECT_EQ(transform->DestinationChannels(1), 4);
+
+    std::unique_ptr<uint8_t[]> gray(image.ConvertToDepth8(0.0));
+    std::unique_ptr<uint8_t[]> falseColour(image.ConvertToDepth8(options));
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(std::vector<uint8_t>(falseColour.get() + 4 * i, falseColour.get() + 4 * i + 4), (std::vector<uint8_t>{7, (uint8_t)(255 - gray[i]), gray[i], 255}));
+    }
+
+    // an equal palette in a different object shares the cached transform
+    DisplayOptions same;
+    same.colormap = std::make_shared<const Colormap>(colors);
+    EXPECT_EQ(DisplayTransform<uint16_t>::Cached(same, 1000, 3000), transform);
+
+    EXPECT_EQ((*Colormap::Jet())[0], (Colormap::Rgb{0, 0, 128}));
+    EXPECT_EQ((*Colormap::Jet())[255], (Colormap::Rgb{128, 0, 0}));
+}
+
+TEST(ImageFrameworkTest, ConvertToDepth8VectorisedDouble)
+{
+    double maxError = 0;
+    for (double x = 1e-300; x < 1e300; x *= 1.37)
+    {
+        maxError = std::max(maxError, std::abs(detail::FastLog2(x) - std::log2(x)));
+    }
+    EXPECT_LT(maxError, 1.1e-9);
+    EXPECT_EQ(detail::FastLog2(0.0), -std::numeric_limits<double>::infinity());
+    EXPECT_TRUE(std::isnan(detail::FastLog2(-1.0)));
+
+    BitmapData<double> image(301, 7, 3);
+    for (int i = 0; i < 301 * 7 * 3; ++i)
+    {
+        image.Buffer()[i] = (i * 7919) % 40000 - 100.5;
+    }
+    image.SetBrightnessRangeForDisplay(0, 30000);
+
+    for (const double gamma : {0.0, 0.4, 1.0})
+    {
+        DisplayOptions options;
+        options.gamma = gamma;
+
+        std::unique_ptr<uint8_t[]> converted(image.ConvertToDepth8(options));
+        const auto                 transform = DisplayTransform<double>::Cached(options, 0, 30000);
+        for (int i = 0; i < 301 * 7; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                EXPECT_NEAR(converted[4 * i + 2 - c], transform->Mapping()(image.Buffer()[3 * i + c]), 1);
+            }
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, InterpolationWithInlineGetter)
+{
+    BitmapData<uint16_t> image(3, 3, 1);
+    for (int i = 0; i < 9; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)(i * 1000);
+    }
+
+    const auto getter = [&image](const int x, const int y)
+    {
+        return MixableScalar<uint16_t>(image.GetGray(x, y));
+    };
+    const interpolation::Getter<MixableScalar<uint16_t>> function = getter;
+
+    EXPECT_EQ(image.GetGray(1.0, 2.0), 7000);
+    EXPECT_EQ(image.GetGray(0.5, 0.0), 500);
+    EXPECT_EQ(image.GetGray(1.0, 0.5), 2500);
+
+    for (double y = 0; y <= 2; y += 0.125)
+    {
+        for (double x = 0; x <= 2; x += 0.125)
+        {
+            const uint16_t inlined = interpolation::Do(x, y, 0.0, 0.0, 2.0, 2.0, getter);
+            EXPECT_EQ(inlined, image.GetGray(x, y));
+            EXPECT_EQ(inlined, (uint16_t)interpolation::Do(x, y, 0.0, 0.0, 2.0, 2.0, function));
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, MixWithArgumentPairs)
+{
+    const Color<uint16_t> a(1000, 2000, 3001, 65535);
+    const Color<uint16_t> b(3000, 0, 65535, 0);
+    const Color<uint16_t> c(7, 9, 11, 13);
+
+    EXPECT_EQ(a.Mix(0.5, b), Color<uint16_t>(2000, 1000, 34268, 32768));
+    EXPECT_EQ(a.Mix(0.25, b, 0.25, c), a.Mix({{0.25, b}, {0.25, c}}));
+    EXPECT_EQ(a.Mix(2.0, b), a.Mix({{2.0, b}})); // outside the fixed-point range
+
+    for (double w = 0; w <= 1; w += 0.01)
+    {
+        const Color<uint8_t> x(10, 200, 37, 255);
+        const Color<uint8_t> y(250, 3, 99, 0);
+        const Color<uint8_t> mixed = x.Mix(w, y);
+        EXPECT_NEAR(mixed.Red(), (1 - w) * 10 + w * 250, 0.5 + 1e-6);
+        EXPECT_NEAR(mixed.Alpha(), (1 - w) * 255, 0.5 + 1e-6);
+    }
+
+    // 0.1 * 5 is slightly above 0.5 and rounds up like the long double sum, although the fixed-point sum is below
+    EXPECT_EQ(Color<uint8_t>(0, 0, 0, 0).Mix(0.1, Color<uint8_t>(5, 5, 5, 5)), Color<uint8_t>(1, 1, 1, 1));
+
+    EXPECT_EQ((uint8_t)MixableScalar<uint8_t>(10).Mix(0.5, MixableScalar<uint8_t>(20)), 15);
+    const Vector v = Vector(std::make_pair(0.0, 2.0)).Mix(0.25, Vector(std::make_pair(4.0, 2.0)));
+    EXPECT_DOUBLE_EQ(v.Vx(), 1.0);
+    EXPECT_DOUBLE_EQ(v.Vy(), 2.0);
+}
+
+TEST(ImageFrameworkTest, ResizeKernels)
+{
+    const ResampleFilter filters[] = {ResampleFilter::Nearest, ResampleFilter::Box, ResampleFilter::Area, ResampleFilter::Bilinear, ResampleFilter::Bicubic, ResampleFilter::Lanczos3};
+
+    BitmapData<uint8_t> flat(17, 9, 3);
+    std::fill(flat.Buffer(), flat.Buffer() + 17 * 9 * 3, (uint8_t)77);
+
+    BitmapData<uint16_t> ramp(40, 30, 1);
+    BitmapData<double>   rampDouble(40, 30, 1);
+    for (int y = 0; y < 30; ++y)
+    {
+        for (int x = 0; x < 40; ++x)
+        {
+            ramp.Buffer()[y * 40 + x]       = (uint16_t)(x * 1500 + y * 7);
+            rampDouble.Buffer()[y * 40 + x] = x * 1500 + y * 7;
+        }
+    }
+
+    for (const ResampleFilter filter : filters)
+    {
+        for (const auto& size : {std::make_pair(5, 4), std::make_pair(41, 23)})
+        {
+            const BitmapData<uint8_t> resized = Resize(flat, size.first, size.second, filter);
+            EXPECT_EQ(resized.Width(), size.first);
+            for (int i = 0; i < size.first * size.second * 3; ++i)
+            {
+                EXPECT_EQ(resized.Buffer()[i], 77);
+            }
+
+            // integer and double precision agree
+            const BitmapData<uint16_t> fixed    = Resize(ramp, size.first, size.second, filter);
+            const BitmapData<double>   floating = Resize(rampDouble, size.first, size.second, filter);
+            for (int i = 0; i < size.first * size.second; ++i)
+            {
+                EXPECT_NEAR(fixed.Buffer()[i], std::min(65535.0, std::max(0.0, floating.Buffer()[i])), 1.0);
+            }
+        }
+    }
+
+    // a 2x area reduction averages 2 x 2 blocks
+    const BitmapData<uint16_t> half = Resize(ramp, 20, 15, ResampleFilter::Area);
+    EXPECT_EQ(half.Buffer()[3 * 20 + 5], (uint16_t)std::lround((10 * 1500 + 11 * 1500) / 2.0 + (6 * 7 + 7 * 7) / 2.0));
+
+    EXPECT_THROW(Resize(ramp, ramp), std::runtime_error);
+}
+
+TEST(ImageFrameworkTest, InterpolationTabulatedWeights)
+{
+    BitmapData<uint8_t> image(16, 16, 1);
+    uint32_t            seed = 12345;
+    for (int i = 0; i < 16 * 16; ++i)
+    {
+        seed              = seed * 1664525 + 1013904223;
+        image.Buffer()[i] = (uint8_t)(seed >> 24);
+    }
+
+    EXPECT_EQ(image.GetGray(3.5, 7.0, interpolation::Mode::Tabulated), image.GetGray(3.5, 7.0));
+    EXPECT_EQ(image.GetGray(3.0, 7.25, interpolation::Mode::Tabulated), image.GetGray(3.0, 7.25));
+    EXPECT_EQ(image.GetGray(15.7, 15.2, interpolation::Mode::Tabulated), image.GetGray(15, 15));
+
+    for (double y = -0.5; y < 16; y += 0.173)
+    {
+        for (double x = -0.5; x < 16; x += 0.117)
+        {
+            const int ix = std::min(15, std::max(0, (int)std::floor(x)));
+            const int iy = std::min(15, std::max(0, (int)std::floor(y)));
+            int       lo = 255;
+            int       hi = 0;
+            for (int v = iy; v <= std::min(15, iy + 1); ++v)
+            {
+                for (int u = ix; u <= std::min(15, ix + 1); ++u)
+                {
+                    lo = std::min<int>(lo, image.GetGray(u, v));
+                    hi = std::max<int>(hi, image.GetGray(u, v));
+                }
+            }
+
+            EXPECT_LE(std::abs(image.GetGray(x, y, interpolation::Mode::Tabulated) - image.GetGray(x, y)), 0.016 * (hi - lo) + 1);
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, WarpAffineAndPerspective)
+{
+    BitmapData<uint16_t> image(150, 90, 3);
+    for (int i = 0; i < 150 * 90 * 3; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)((i * 2654435761u) >> 16);
+    }
+
+    const WarpFilter filters[] = {WarpFilter::Nearest, WarpFilter::Bilinear, WarpFilter::Bicubic, WarpFilter::EdgeAware, WarpFilter::EdgeAwareTabulated};
+    for (const WarpFilter filter : filters)
+    {
+        WarpOptions options;
+        options.filter = filter;
+
+        const BitmapData<uint16_t> affine      = WarpAffine(image, AffineMatrix{1, 0, 0, 0, 1, 0}, 150, 90, options);
+        const BitmapData<uint16_t> perspective = WarpPerspective(image, PerspectiveMatrix{2, 0, 0, 0, 2, 0, 0, 0, 2}, 150, 90, options);
+        EXPECT_TRUE(std::equal(image.Buffer(), image.Buffer() + 150 * 90 * 3, affine.Buffer()));
+        EXPECT_TRUE(std::equal(image.Buffer(), image.Buffer() + 150 * 90 * 3, perspective.Buffer()));
+    }
+
+    // rotation by 90 degrees: destination (x, y) reads source (y, 89 - x); pixels beyond the source get the fill
+    WarpOptions options;
+    options.filter = WarpFilter::Nearest;
+    options.fill   = 7;
+    const BitmapData<uint16_t> rotated = WarpAffine(image, Invert(AffineMatrix{0, -1, 89, 1, 0, 0}), 100, 150, options);
+    for (int y = 0; y < 150; ++y)
+    {
+        for (int x = 0; x < 100; ++x)
+        {
+            EXPECT_EQ(rotated.Get(x, y), x < 90 ? image.Get(y, 89 - x) : Color<uint16_t>(7));
+        }
+    }
+
+    // half a pixel to the right with bilinear weights averages neighbours
+    const BitmapData<uint16_t> shifted = WarpAffine(image, AffineMatrix{1, 0, 0.5, 0, 1, 0}, 149, 90);
+    EXPECT_EQ(shifted.Get(10, 20).Green(), (uint16_t)std::lround((image.Get(10, 20).Green() + image.Get(11, 20).Green()) / 2.0));
+}
+
+TEST(ImageFrameworkTest, RemapFixedPointTable)
+{
+    BitmapData<uint8_t> image(40, 30, 4);
+    for (int i = 0; i < 40 * 30 * 4; ++i)
+    {
+        image.Buffer()[i] = (uint8_t)((i * 2654435761u) >> 24);
+    }
+
+    // identity, half a pixel to the right, and mirrored beyond the right border
+    const RemapTable identity = RemapTable::FromFunction(40, 30, 40, 30, [](const int x, const int y)
+                                                         { return std::array<double, 2>{(double)x, (double)y}; });
+    const RemapTable shifted  = RemapTable::FromFunction(39, 30, 40, 30, [](const int x, const int y)
+                                                        { return std::array<double, 2>{x + 0.5, (double)y}; });
+    const RemapTable outside  = RemapTable::FromFunction(10, 30, 40, 30, [](const int x, const int y)
+                                                        { return std::array<double, 2>{x + 35.0, (double)y}; });
+
+    const BitmapData<uint8_t> same = Remap(image, identity);
+    EXPECT_TRUE(std::equal(image.Buffer(), image.Buffer() + 40 * 30 * 4, same.Buffer()));
+
+    const BitmapData<uint8_t> half = Remap(image, shifted);
+    for (int x = 0; x < 39; ++x)
+    {
+        EXPECT_EQ(half.Get(x, 7).Red(), (uint8_t)((image.Get(x, 7).Red() + image.Get(x + 1, 7).Red() + 1) / 2));
+    }
+
+    const BitmapData<uint8_t> filled = Remap(image, outside, 9.0);
+    EXPECT_EQ(filled.Get(4, 3), image.Get(39, 3));
+    EXPECT_EQ(filled.Get(5, 3), Color<uint8_t>(9, 9, 9, 9));
+
+    // the same table applies to any sample type of the source size
+    BitmapData<double> gray(40, 30, 1);
+    for (int i = 0; i < 40 * 30; ++i)
+    {
+        gray.Buffer()[i] = i * 0.25;
+    }
+    EXPECT_DOUBLE_EQ(Remap(gray, shifted).GetGray(3, 2), (2 * 40 + 3.5) * 0.25);
+
+    // positions are 32 bit
+    EXPECT_THROW(RemapTable({}, {}, 0, 0, 65536, 32769), std::runtime_error);
+    EXPECT_NO_THROW(RemapTable({}, {}, 0, 0, 65536, 32768));
+
+    EXPECT_THROW(Remap(BitmapData<uint8_t>(20, 30, 4), identity), std::runtime_error);
+    EXPECT_THROW(RemapTable(std::vector<float>(5), std::vector<float>(6), 5, 1, 40, 30), std::runtime_error);
+}
+
+TEST(ImageFrameworkTest, BatchedPointSampling)
+{
+    BitmapData<uint16_t> image(64, 48, 3);
+    for (int i = 0; i < 64 * 48 * 3; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)((i * 2654435761u) >> 16);
+    }
+
+    std::vector<std::pair<double, double>> positions;
+    for (int i = 0; i < 5000; ++i)
+    {
+        // spread over and slightly beyond the image, in no particular row order
+        positions.emplace_back(((i * 7919) % 6600) / 100.0 - 1.0, ((i * 104729) % 5000) / 100.0 - 1.0);
+    }
+
+    for (const interpolation::Mode mode : {interpolation::Mode::Exact, interpolation::Mode::Tabulated})
+    {
+        std::vector<Color<uint16_t>> colors(positions.size(), Color<uint16_t>(0));
+        std::vector<uint16_t>        grays(positions.size());
+        image.Get(positions.data(), positions.size(), colors.data(), mode);
+        image.GetGray(positions.data(), positions.size(), grays.data(), mode);
+
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            EXPECT_EQ(colors[i], image.Get(positions[i].first, positions[i].second, mode));
+            EXPECT_EQ(grays[i], image.GetGray(positions[i].first, positions[i].second, mode));
+        }
+    }
+
+    // an empty image can answer no queries, but an empty batch
+    const BitmapData<uint8_t>       empty(0, 0, 1);
+    const std::pair<double, double> origin{0.0, 0.0};
+    uint8_t                         gray = 0;
+    EXPECT_NO_THROW(empty.GetGray(&origin, 0, &gray));
+    EXPECT_THROW(empty.GetGray(&origin, 1, &gray), std::runtime_error);
+}
+
+TEST(ImageFrameworkTest, RotateTransposeAndFlip)
+{
+    BitmapData<uint16_t> image(70, 45, 3);
+    for (int i = 0; i < 70 * 45 * 3; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)((i * 2654435761u) >> 16);
+    }
+
+    const BitmapData<uint16_t> transposed = Transpose(image);
+    const BitmapData<uint16_t> rotated90  = Rotate(image, Rotation::Rotate90);
+    const BitmapData<uint16_t> rotated180 = Rotate(image, Rotation::Rotate180);
+    const BitmapData<uint16_t> rotated270 = Rotate(image, Rotation::Rotate270);
+    const BitmapData<uint16_t> flippedH   = Flip(image, FlipDirection::Horizontal);
+    const BitmapData<uint16_t> flippedV   = Flip(image, FlipDirection::Vertical);
+
+    ASSERT_EQ(rotated90.Width(), 45);
+    ASSERT_EQ(rotated90.Height(), 70);
+    for (int y = 0; y < 45; ++y)
+    {
+        for (int x = 0; x < 70; ++x)
+        {
+            const Color<uint16_t> c = image.Get(x, y);
+            EXPECT_EQ(transposed.Get(y, x), c);
+            EXPECT_EQ(rotated90.Get(44 - y, x), c);
+            EXPECT_EQ(rotated180.Get(69 - x, 44 - y), c);
+            EXPECT_EQ(rotated270.Get(y, 69 - x), c);
+            EXPECT_EQ(flippedH.Get(69 - x, y), c);
+            EXPECT_EQ(flippedV.Get(x, 44 - y), c);
+        }
+    }
+
+    // in place, on a square gray image spanning several tiles
+    BitmapData<uint8_t> square(77, 77, 1);
+    for (int i = 0; i < 77 * 77; ++i)
+    {
+        square.Buffer()[i] = (uint8_t)((i * 2654435761u) >> 24);
+    }
+
+    for (const Rotation rotation : {Rotation::Rotate90, Rotation::Rotate180, Rotation::Rotate270})
+    {
+        BitmapData<uint8_t>       inPlace(square);
+        const BitmapData<uint8_t> expected = Rotate(square, rotation);
+        RotateInPlace(inPlace, rotation);
+        EXPECT_TRUE(std::equal(expected.Buffer(), expected.Buffer() + 77 * 77, inPlace.Buffer()));
+    }
+
+    BitmapData<uint16_t> flipped(image);
+    FlipInPlace(flipped, FlipDirection::Horizontal);
+    FlipInPlace(flipped, FlipDirection::Vertical);
+    EXPECT_TRUE(std::equal(rotated180.Buffer(), rotated180.Buffer() + 70 * 45 * 3, flipped.Buffer()));
+
+    EXPECT_THROW(RotateInPlace(flipped, Rotation::Rotate90), std::runtime_error);
+    EXPECT_THROW(Transpose(image, flipped), std::runtime_error);
+}
+
+TEST(ImageFrameworkTest, RotateByAngleWithShears)
+{
+    BitmapData<uint16_t> image(80, 50, 3);
+    for (int y = 0; y < 50; ++y)
+    {
+        for (int x = 0; x < 80; ++x)
+        {
+            uint16_t* p = image.Buffer() + (y * 80 + x) * 3;
+            p[0]        = (uint16_t)(1000 + 30 * x + 20 * y);
+            p[1]        = (uint16_t)(5000 - 10 * x);
+            p[2]        = (uint16_t)(300 + 40 * y);
+        }
+    }
+
+    const BitmapData<uint16_t> same = RotateByAngle(image, 0.0);
+    EXPECT_TRUE(std::equal(image.Buffer(), image.Buffer() + 80 * 50 * 3, same.Buffer()));
+
+    const BitmapData<uint16_t> quarter = RotateByAngle(image, std::acos(0.0), RotateBounds::Expand);
+    const BitmapData<uint16_t> exact   = Rotate(image, Rotation::Rotate90);
+    ASSERT_EQ(quarter.Width(), 50);
+    ASSERT_EQ(quarter.Height(), 80);
+    EXPECT_TRUE(std::equal(exact.Buffer(), exact.Buffer() + 80 * 50 * 3, quarter.Buffer()));
+
+    // on a linear ramp, linear interpolation is exact, so the shears must match a bilinear affine warp inside
+    for (const double angle : {0.3, -0.7, 2.0})
+    {
+        const BitmapData<uint16_t> rotated = RotateByAngle(image, angle, RotateBounds::Expand, 7.0);
+        EXPECT_EQ(rotated.Width(), (int)std::ceil(80 * std::abs(std::cos(angle)) + 50 * std::abs(std::sin(angle)) - 1e-6));
+
+        const double c  = std::cos(angle);
+        const double s  = std::sin(angle);
+        const double cx = (rotated.Width() - 1) / 2.0;
+        const double cy = (rotated.Height() - 1) / 2.0;
+
+        const AffineMatrix         toSource = {c, s, 39.5 - c * cx - s * cy, -s, c, 24.5 + s * cx - c * cy};
+        const BitmapData<uint16_t> warped   = WarpAffine(image, toSource, rotated.Width(), rotated.Height());
+
+        for (int y = 0; y < rotated.Height(); ++y)
+        {
+            for (int x = 0; x < rotated.Width(); ++x)
+            {
+                const double sx = toSource[0] * x + toSource[1] * y + toSource[2];
+                const double sy = toSource[3] * x + toSource[4] * y + toSource[5];
+                if (sx > 1.5 && sx < 77.5 && sy > 1.5 && sy < 47.5)
+                {
+                    EXPECT_NEAR(rotated.Get(x, y).Red(), warped.Get(x, y).Red(), 1);
+                    EXPECT_NEAR(rotated.Get(x, y).Blue(), warped.Get(x, y).Blue(), 1);
+                }
+                else if (sx < -2 || sx > 81 || sy < -2 || sy > 51)
+                {
+                    EXPECT_EQ(rotated.Get(x, y), Color<uint16_t>(7, 7, 7));
+                }
+            }
+        }
+    }
+}
+
+TEST(ImageFrameworkTest, BinSumAndAverage)
+{
+    BitmapData<uint16_t> image(101, 61, 3);
+    for (int i = 0; i < 101 * 61 * 3; ++i)
+    {
+        image.Buffer()[i] = (uint16_t)((i * 2654435761u) >> 16);
+    }
+
+    for (const int factor : {2, 3, 4, 5})
+    {
+        const BitmapData<uint32_t> sum     = Bin<uint32_t>(image, factor, BinMode::Sum);
+        const BitmapData<uint16_t> average = Bin(image, factor);
+        const BitmapData<uint16_t> clipped = Bin(image, factor, BinMode::Sum);
+
+        ASSERT_EQ(sum.Width(), 101 / factor);
+        ASSERT_EQ(sum.Height(), 61 / factor);
+
+        for (int y = 0; y < sum.Height(); ++y)
+        {
+            for (int x = 0; x < sum.Width(); ++x)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint32_t expected = 0;
+                    for (int j = 0; j < factor; ++j)
+                    {
+                        for (int i = 0; i < factor; ++i)
+                        {
+                            expected += image.Buffer()[((y * factor + j) * 101 + x * factor + i) * 3 + c];
+                        }
+                    }
+
+                    const size_t k = ((size_t)y * sum.Width() + x) * 3 + c;
+                    EXPECT_EQ(sum.Buffer()[k], expected);
+                    EXPECT_EQ(average.Buffer()[k], (expected + factor * factor / 2) / (factor * factor));
+                    EXPECT_EQ(clipped.Buffer()[k], std::min<uint32_t>(expected, 65535));
+                }
+            }
+        }
+    }
+
+    // non-square blocks and floating point output
+    BitmapData<double> gray(6, 4, 1);
+    for (int i = 0; i < 24; ++i)
+    {
+        gray.Buffer()[i] = i;
+    }
+    const BitmapData<double> binned = Bin(gray, 3, 2);
+    EXPECT_DOUBLE_EQ(binned.GetGray(0, 0), (0 + 1 + 2 + 6 + 7 + 8) / 6.0);
+    EXPECT_DOUBLE_EQ(binned.GetGray(1, 1), (15 + 16 + 17 + 21 + 22 + 23) / 6.0);
+
+    // the display range scales with the sums, but the default range of double images stays finite
+    const BitmapData<double> summed = Bin(gray, 3, 2, BinMode::Sum);
+    EXPECT_EQ(summed.GetMaxDisplayedBrightness(), std::numeric_limits<double>::max());
+    EXPECT_EQ(binned.GetMaxDisplayedBrightness(), std::numeric_limits<double>::max());
+    gray.SetBrightnessRangeForDisplay(0, 23);
+    EXPECT_DOUBLE_EQ(Bin(gray, 3, 2, BinMode::Sum).GetMaxDisplayedBrightness(), 23 * 6.0);
+    EXPECT_EQ(Bin<uint32_t>(image, 2, BinMode::Sum).GetMaxDisplayedBrightness(), 65535u * 4);
+
+    // averages into a floating point type are not rounded
+    BitmapData<uint16_t> single(2, 2, 1);
+    std::fill(single.Buffer(), single.Buffer() + 4, (uint16_t)0);
+    single.Buffer()[0] = 1;
+    EXPECT_DOUBLE_EQ(Bin<double>(single, 2).GetGray(0, 0), 0.25);
+
+    EXPECT_THROW(Bin(image, 0), std::runtime_error);
+}